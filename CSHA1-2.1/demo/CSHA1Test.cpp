@@ -69,23 +69,18 @@ void HashString()
 	tstring strReport;
 
 #ifdef _UNICODE
-	const size_t uAnsiLen = wcstombs(NULL, str.c_str(), 0) + 1;
-	char* pszAnsi = new char[uAnsiLen + 1];
-	wcstombs(pszAnsi, str.c_str(), uAnsiLen);
-
-	sha1.Update((UINT_8*)&pszAnsi[0], strlen(&pszAnsi[0]));
+	sha1.UpdateText(str.c_str(), str.size(), CSHA1::TEXT_UTF8);
 	sha1.Final();
 	sha1.ReportHashStl(strReport, CSHA1::REPORT_HEX_SHORT);
-	tcout << _T("Hash of the ANSI representation of the string:") << endl;
+	tcout << _T("Hash of the UTF-8 representation of the string:") << endl;
 	tcout << strReport << endl << endl;
 
-	delete[] pszAnsi;
 	sha1.Reset();
 
-	sha1.Update((UINT_8*)str.c_str(), str.size() * sizeof(TCHAR));
+	sha1.UpdateText(str.c_str(), str.size(), CSHA1::TEXT_UTF16LE);
 	sha1.Final();
 	sha1.ReportHashStl(strReport, CSHA1::REPORT_HEX_SHORT);
-	tcout << _T("Hash of the Unicode representation of the string:") << endl;
+	tcout << _T("Hash of the UTF-16LE representation of the string:") << endl;
 	tcout << strReport << endl;
 #else
 	sha1.Update((UINT_8*)str.c_str(), str.size() * sizeof(TCHAR));
@@ -10,9 +10,38 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 #include "SHA1.h"
+#include "SHA1Probes.h"
+
+// Statistics require C++11; SHA1StatsEnable sets the hook, so that this
+// file does not depend on SHA1Stats.cpp
+#if defined(SHA1_HAS_CPP11) && !defined(SHA1_NO_STATS)
+#include "SHA1Stats.h"
+#define SHA1_FINAL_STATS
+std::atomic<SHA1_STATS_MESSAGE_HOOK> g_pfnSHA1StatsFinal(NULL);
+#endif
 
 #define SHA1_MAX_FILE_BUFFER (32 * 20 * 820)
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SHA1_TEXT_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef SHA1_USDT
+#define SHA1_PROBE_SEMAPHORE(n) __extension__ volatile unsigned short \
+	csha1_##n##_semaphore __attribute__((section(".probes"))) = 0
+
+extern "C"
+{
+	SHA1_PROBE_SEMAPHORE(file_open);
+	SHA1_PROBE_SEMAPHORE(chunk_read);
+	SHA1_PROBE_SEMAPHORE(chunk_hash);
+	SHA1_PROBE_SEMAPHORE(file_close);
+	SHA1_PROBE_SEMAPHORE(final);
+	SHA1_PROBE_SEMAPHORE(kernel_dispatch);
+}
+#endif
+
 // Rotate p_val32 by p_nBits bits to the left
 #ifndef ROL32
 #ifdef _MSC_VER
@@ -138,16 +167,253 @@ void CSHA1::Update(const UINT_8* pbData, UINT_32 uLen)
 		memcpy(&m_buffer[j], &pbData[i], uLen - i);
 }
 
-#ifdef SHA1_UTILITY_FUNCTIONS
-bool CSHA1::HashFile(const TCHAR* tszFileName)
+void CSHA1::UpdateV(const SHA1_IOVEC* pVec, size_t uCount)
+{
+	if(pVec == NULL) return;
+
+	for(size_t v = 0; v < uCount; ++v)
+	{
+		const UINT_8* pbData = static_cast<const UINT_8*>(pVec[v].iov_base);
+		const size_t uLen = pVec[v].iov_len;
+		if((pbData == NULL) || (uLen == 0)) continue;
+
+		size_t j = ((m_count[0] >> 3) & 0x3F);
+		AddByteCount(uLen);
+
+		// Only bytes of a block that straddles two fragments are staged
+		size_t i = 0;
+		if(j != 0)
+		{
+			i = (((64 - j) < uLen) ? (64 - j) : uLen);
+			memcpy(&m_buffer[j], pbData, i);
+			j += i;
+			if(j < 64) continue;
+
+			Transform(m_state, m_buffer);
+			j = 0;
+		}
+
+		// Full blocks are transformed in place
+		for( ; (i + 64) <= uLen; i += 64)
+			Transform(m_state, &pbData[i]);
+
+		if(i < uLen)
+			memcpy(&m_buffer[j], &pbData[i], uLen - i);
+	}
+}
+
+void CSHA1::AddByteCount(UINT_64 uBytes)
+{
+	UINT_64 uBits = ((static_cast<UINT_64>(m_count[1]) << 32) | m_count[0]);
+	uBits += (uBytes << 3);
+	m_count[0] = static_cast<UINT_32>(uBits & 0xFFFFFFFF);
+	m_count[1] = static_cast<UINT_32>(uBits >> 32);
+}
+
+// Returns the number of bytes written to pbOut (at most 4)
+static size_t SHA1EncodeCodePoint(UINT_32 uCP, CSHA1::TEXT_ENCODING enc, UINT_8* pbOut)
+{
+	if(((uCP >= 0xD800) && (uCP <= 0xDFFF)) || (uCP > 0x10FFFF))
+		uCP = 0xFFFD;
+
+	if(enc == CSHA1::TEXT_UTF16LE)
+	{
+		if(uCP < 0x10000)
+		{
+			pbOut[0] = static_cast<UINT_8>(uCP & 0xFF);
+			pbOut[1] = static_cast<UINT_8>(uCP >> 8);
+			return 2;
+		}
+
+		const UINT_32 uHigh = 0xD800 + ((uCP - 0x10000) >> 10);
+		const UINT_32 uLow = 0xDC00 + (uCP & 0x3FF);
+		pbOut[0] = static_cast<UINT_8>(uHigh & 0xFF);
+		pbOut[1] = static_cast<UINT_8>(uHigh >> 8);
+		pbOut[2] = static_cast<UINT_8>(uLow & 0xFF);
+		pbOut[3] = static_cast<UINT_8>(uLow >> 8);
+		return 4;
+	}
+
+	if(uCP < 0x80)
+	{
+		pbOut[0] = static_cast<UINT_8>(uCP);
+		return 1;
+	}
+	if(uCP < 0x800)
+	{
+		pbOut[0] = static_cast<UINT_8>(0xC0 | (uCP >> 6));
+		pbOut[1] = static_cast<UINT_8>(0x80 | (uCP & 0x3F));
+		return 2;
+	}
+	if(uCP < 0x10000)
+	{
+		pbOut[0] = static_cast<UINT_8>(0xE0 | (uCP >> 12));
+		pbOut[1] = static_cast<UINT_8>(0x80 | ((uCP >> 6) & 0x3F));
+		pbOut[2] = static_cast<UINT_8>(0x80 | (uCP & 0x3F));
+		return 3;
+	}
+
+	pbOut[0] = static_cast<UINT_8>(0xF0 | (uCP >> 18));
+	pbOut[1] = static_cast<UINT_8>(0x80 | ((uCP >> 12) & 0x3F));
+	pbOut[2] = static_cast<UINT_8>(0x80 | ((uCP >> 6) & 0x3F));
+	pbOut[3] = static_cast<UINT_8>(0x80 | (uCP & 0x3F));
+	return 4;
+}
+
+// The transcoders write into m_buffer at position j and transform each
+// block as soon as it is complete; m_count is updated once at the end
+template<typename T> void CSHA1::UpdateUtf16(const T* pData, size_t uLen, TEXT_ENCODING enc)
+{
+	if((pData == NULL) || (uLen == 0)) return;
+
+#ifdef SHA1_LITTLE_ENDIAN
+	if(enc == TEXT_UTF16LE) // Code units are hashed as they are
+	{
+		SHA1_IOVEC v;
+		v.iov_base = const_cast<T*>(pData);
+		v.iov_len = uLen * 2;
+		UpdateV(&v, 1);
+		return;
+	}
+#endif
+
+	size_t j = ((m_count[0] >> 3) & 0x3F);
+	UINT_64 uOut = 0;
+	UINT_8 pbCP[4];
+	size_t i = 0;
+
+	while(i < uLen)
+	{
+#ifdef SHA1_TEXT_SSE2
+		// 8 ASCII code units at once
+		if((enc == TEXT_UTF8) && ((i + 8) <= uLen) && (j <= 56))
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pData[i]));
+			const __m128i vHigh = _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80)));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi16(vHigh, _mm_setzero_si128())) == 0xFFFF)
+			{
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(&m_buffer[j]), _mm_packus_epi16(v, v));
+				i += 8;
+				uOut += 8;
+				j += 8;
+				if(j == 64) { Transform(m_state, m_buffer); j = 0; }
+				continue;
+			}
+		}
+#endif
+
+		UINT_32 uCP = static_cast<UINT_32>(pData[i]) & 0xFFFF;
+		++i;
+
+		size_t n;
+		if((uCP >= 0xD800) && (uCP <= 0xDBFF) && (i < uLen) &&
+			((static_cast<UINT_32>(pData[i]) & 0xFC00) == 0xDC00))
+		{
+			uCP = 0x10000 + ((uCP - 0xD800) << 10) + ((static_cast<UINT_32>(pData[i]) & 0xFFFF) - 0xDC00);
+			++i;
+			n = SHA1EncodeCodePoint(uCP, enc, pbCP);
+		}
+		else if((enc == TEXT_UTF16LE) && (uCP >= 0xD800) && (uCP <= 0xDFFF))
+		{
+			pbCP[0] = static_cast<UINT_8>(uCP & 0xFF);
+			pbCP[1] = static_cast<UINT_8>(uCP >> 8);
+			n = 2;
+		}
+		else n = SHA1EncodeCodePoint(uCP, enc, pbCP);
+
+		for(size_t k = 0; k < n; ++k)
+		{
+			m_buffer[j] = pbCP[k];
+			if(++j == 64) { Transform(m_state, m_buffer); j = 0; }
+		}
+		uOut += n;
+	}
+
+	AddByteCount(uOut);
+}
+
+template<typename T> void CSHA1::UpdateUtf32(const T* pData, size_t uLen, TEXT_ENCODING enc)
+{
+	if((pData == NULL) || (uLen == 0)) return;
+
+	size_t j = ((m_count[0] >> 3) & 0x3F);
+	UINT_64 uOut = 0;
+	UINT_8 pbCP[4];
+	size_t i = 0;
+
+	while(i < uLen)
+	{
+#ifdef SHA1_TEXT_SSE2
+		// 8 code units below 0x80 (UTF-8) or 0x8000 (UTF-16LE) at once
+		const size_t uOutLen = ((enc == TEXT_UTF8) ? 8 : 16);
+		if(((i + 8) <= uLen) && (j <= (64 - uOutLen)))
+		{
+			const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pData[i]));
+			const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pData[i + 4]));
+			const __m128i vMask = _mm_set1_epi32(static_cast<int>((enc == TEXT_UTF8) ?
+				0xFFFFFF80 : 0xFFFF8000));
+			const __m128i vHigh = _mm_and_si128(_mm_or_si128(v0, v1), vMask);
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(vHigh, _mm_setzero_si128())) == 0xFFFF)
+			{
+				const __m128i v16 = _mm_packs_epi32(v0, v1);
+				if(enc == TEXT_UTF8)
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(&m_buffer[j]), _mm_packus_epi16(v16, v16));
+				else _mm_storeu_si128(reinterpret_cast<__m128i*>(&m_buffer[j]), v16);
+
+				i += 8;
+				uOut += uOutLen;
+				j += uOutLen;
+				if(j == 64) { Transform(m_state, m_buffer); j = 0; }
+				continue;
+			}
+		}
+#endif
+
+		const size_t n = SHA1EncodeCodePoint(static_cast<UINT_32>(pData[i]), enc, pbCP);
+		++i;
+
+		for(size_t k = 0; k < n; ++k)
+		{
+			m_buffer[j] = pbCP[k];
+			if(++j == 64) { Transform(m_state, m_buffer); j = 0; }
+		}
+		uOut += n;
+	}
+
+	AddByteCount(uOut);
+}
+
+void CSHA1::UpdateText(const wchar_t* pwData, size_t uLen, TEXT_ENCODING enc)
+{
+	if(sizeof(wchar_t) == 2) UpdateUtf16(pwData, uLen, enc);
+	else UpdateUtf32(pwData, uLen, enc);
+}
+
+#ifdef SHA1_CHAR16_CHAR32
+void CSHA1::UpdateText(const char16_t* pData, size_t uLen, TEXT_ENCODING enc)
+{
+	UpdateUtf16(pData, uLen, enc);
+}
+
+void CSHA1::UpdateText(const char32_t* pData, size_t uLen, TEXT_ENCODING enc)
+{
+	UpdateUtf32(pData, uLen, enc);
+}
+#endif
+
+#if defined(SHA1_UTILITY_FUNCTIONS) && !defined(SHA1_HAS_CPP11)
+// The instrumented version is in SHA1HashFile.cpp
+bool CSHA1::HashFile(const TCHAR* tszFileName, CSHA1BufferArena* pArena,
+	CSHA1HashControl* pControl)
 {
+	(void)pArena;
+	(void)pControl;
 	if(tszFileName == NULL) return false;
 
 	FILE* fpIn = _tfopen(tszFileName, _T("rb"));
 	if(fpIn == NULL) return false;
 
 	UINT_8* pbData = new UINT_8[SHA1_MAX_FILE_BUFFER];
-	if(pbData == NULL) { fclose(fpIn); return false; }
 
 	bool bSuccess = true;
 	while(true)
@@ -170,10 +436,89 @@ bool CSHA1::HashFile(const TCHAR* tszFileName)
 }
 #endif
 
+static void SHA1StoreBE(UINT_8* pbDest, UINT_64 uValue, size_t uBytes)
+{
+	for(size_t i = 0; i < uBytes; ++i)
+		pbDest[i] = static_cast<UINT_8>((uValue >> ((uBytes - 1 - i) * 8)) & 0xFF);
+}
+
+// Bitwise CRC-32C of the serialized state; SHA1.cpp does not depend on
+// the table-driven one of SHA1MultiHash.cpp
+static UINT_32 SHA1StateCrc32c(const UINT_8* pbData, size_t uLen)
+{
+	UINT_32 uCrc = 0xFFFFFFFF;
+	for(size_t i = 0; i < uLen; ++i)
+	{
+		uCrc ^= pbData[i];
+		for(int b = 0; b < 8; ++b)
+			uCrc = ((uCrc >> 1) ^ (0x82F63B78 & (0 - (uCrc & 1))));
+	}
+
+	return ~uCrc;
+}
+
+static UINT_64 SHA1LoadBE(const UINT_8* pbSrc, size_t uBytes)
+{
+	UINT_64 uValue = 0;
+	for(size_t i = 0; i < uBytes; ++i) uValue = ((uValue << 8) | pbSrc[i]);
+	return uValue;
+}
+
+UINT_64 CSHA1::GetByteCount() const
+{
+	return (((static_cast<UINT_64>(m_count[1]) << 32) | m_count[0]) >> 3);
+}
+
+bool CSHA1::SaveState(UINT_8* pbDest, size_t uDestSize) const
+{
+	if((pbDest == NULL) || (uDestSize < SHA1_STATE_SIZE)) return false;
+
+	const UINT_64 uBytes = GetByteCount();
+	const size_t uPartial = static_cast<size_t>(uBytes & 63);
+
+	memcpy(pbDest, "CSH1", 4);
+	pbDest[4] = SHA1_STATE_VERSION;
+	pbDest[5] = pbDest[6] = pbDest[7] = 0;
+	for(size_t i = 0; i < 5; ++i)
+		SHA1StoreBE(&pbDest[8 + (i * 4)], m_state[i], 4);
+	SHA1StoreBE(&pbDest[28], uBytes, 8);
+	memcpy(&pbDest[36], m_buffer, uPartial);
+	memset(&pbDest[36 + uPartial], 0, 64 - uPartial);
+	SHA1StoreBE(&pbDest[100], SHA1StateCrc32c(pbDest, 100), 4);
+	return true;
+}
+
+bool CSHA1::LoadState(const UINT_8* pbSrc, size_t uSrcSize)
+{
+	if((pbSrc == NULL) || (uSrcSize < SHA1_STATE_SIZE)) return false;
+
+	if(memcmp(pbSrc, "CSH1", 4) != 0) return false;
+	if(pbSrc[4] != SHA1_STATE_VERSION) return false;
+	if(SHA1LoadBE(&pbSrc[100], 4) != SHA1StateCrc32c(pbSrc, 100)) return false;
+
+	const UINT_64 uBytes = SHA1LoadBE(&pbSrc[28], 8);
+	if(uBytes > (static_cast<UINT_64>(-1) >> 3)) return false;
+
+	for(size_t i = 0; i < 5; ++i)
+		m_state[i] = static_cast<UINT_32>(SHA1LoadBE(&pbSrc[8 + (i * 4)], 4));
+	const UINT_64 uBits = (uBytes << 3);
+	m_count[0] = static_cast<UINT_32>(uBits & 0xFFFFFFFF);
+	m_count[1] = static_cast<UINT_32>(uBits >> 32);
+	memcpy(m_buffer, &pbSrc[36], 64);
+	return true;
+}
+
 void CSHA1::Final()
 {
 	UINT_32 i;
 
+#ifdef SHA1_FINAL_STATS
+	const SHA1_STATS_MESSAGE_HOOK pfnStats = g_pfnSHA1StatsFinal.load(std::memory_order_relaxed);
+	if(pfnStats != NULL) pfnStats(SHA1_STATS_KERNEL_SCALAR, GetByteCount());
+#endif
+	if(SHA1_PROBE_ENABLED(final))
+		SHA1_PROBE2(final, GetByteCount(), 0); // Backend 0: SHA1_STATS_KERNEL_SCALAR
+
 	UINT_8 pbFinalCount[8];
 	for(i = 0; i < 8; ++i)
 		pbFinalCount[i] = static_cast<UINT_8>((m_count[((i >= 4) ? 0 : 1)] >>
@@ -205,33 +550,34 @@ bool CSHA1::ReportHash(TCHAR* tszReport, REPORT_TYPE rtReportType) const
 {
 	if(tszReport == NULL) return false;
 
-	TCHAR tszTemp[16];
+	// Characters are written directly; no format strings, no appending
+	static const char* const pszHex = "0123456789ABCDEF";
+	TCHAR* p = tszReport;
 
 	if((rtReportType == REPORT_HEX) || (rtReportType == REPORT_HEX_SHORT))
 	{
-		_sntprintf(tszTemp, 15, _T("%02X"), m_digest[0]);
-		_tcscpy(tszReport, tszTemp);
-
-		const TCHAR* lpFmt = ((rtReportType == REPORT_HEX) ? _T(" %02X") : _T("%02X"));
-		for(size_t i = 1; i < 20; ++i)
+		for(size_t i = 0; i < 20; ++i)
 		{
-			_sntprintf(tszTemp, 15, lpFmt, m_digest[i]);
-			_tcscat(tszReport, tszTemp);
+			if((i != 0) && (rtReportType == REPORT_HEX)) *p++ = _T(' ');
+			*p++ = static_cast<TCHAR>(pszHex[m_digest[i] >> 4]);
+			*p++ = static_cast<TCHAR>(pszHex[m_digest[i] & 0x0F]);
 		}
 	}
 	else if(rtReportType == REPORT_DIGIT)
 	{
-		_sntprintf(tszTemp, 15, _T("%u"), m_digest[0]);
-		_tcscpy(tszReport, tszTemp);
-
-		for(size_t i = 1; i < 20; ++i)
+		for(size_t i = 0; i < 20; ++i)
 		{
-			_sntprintf(tszTemp, 15, _T(" %u"), m_digest[i]);
-			_tcscat(tszReport, tszTemp);
+			if(i != 0) *p++ = _T(' ');
+
+			const UINT_8 b = m_digest[i];
+			if(b >= 100) *p++ = static_cast<TCHAR>('0' + (b / 100));
+			if(b >= 10) *p++ = static_cast<TCHAR>('0' + ((b / 10) % 10));
+			*p++ = static_cast<TCHAR>('0' + (b % 10));
 		}
 	}
 	else return false;
 
+	*p = 0;
 	return true;
 }
 #endif
@@ -240,9 +586,10 @@ bool CSHA1::ReportHash(TCHAR* tszReport, REPORT_TYPE rtReportType) const
 bool CSHA1::ReportHashStl(std::basic_string<TCHAR>& strOut, REPORT_TYPE rtReportType) const
 {
 	TCHAR tszOut[84];
-	const bool bResult = ReportHash(tszOut, rtReportType);
-	if(bResult) strOut = tszOut;
-	return bResult;
+	if(!ReportHash(tszOut, rtReportType)) return false;
+
+	strOut.assign(tszOut);
+	return true;
 }
 #endif
 
@@ -3,6 +3,80 @@
   by Dominik Reichl <dominik.reichl@t-online.de>
   Web: http://www.dominik-reichl.de/
 
+  Version 2.2 - 2026-10-19
+  - Added stream adapters (SHA1Stream.h) that hash data as it is written
+    to or read from a std::streambuf, optionally forwarding it (tee).
+  - Added UpdateV method for hashing scatter-gather (iovec) lists
+    without coalescing them first.
+  - Added content-defined chunker (SHA1Chunker.h) that splits buffers,
+    streams and memory-mapped files into variable-size chunks and hashes
+    them in parallel.
+  - Added content-addressable blob store (SHA1BlobStore.h) keyed by
+    SHA-1 digests.
+  - Added persistent file digest cache (SHA1HashCache.h), keyed by device,
+    inode, size and timestamps, so that unchanged files are not re-read.
+  - Added lock-free concurrent set of SHA-1 digests (SHA1DigestSet.h).
+  - Added allocation-free hex, Base32 and Base64url digest encoders and
+    decoders with bulk variants (SHA1Encode.h).
+  - ReportHash now writes the characters directly instead of formatting
+    and appending each byte.
+  - Added CSHA1Digest value type with ordering, std::hash support and
+    compile-time hex parsing, and a parallel radix sort and duplicate
+    removal for large digest arrays (SHA1Digest.h).
+  - Added duplicate file finder (SHA1DupFinder.h) that groups files by
+    size, hashes head and tail samples and only then full contents, with
+    an optional final byte comparison.
+  - Added asynchronous job manager (SHA1JobManager.h) that batches
+    independent messages from many producers, flushes partial batches
+    after a deadline and reports digests via callbacks or futures.
+  - Added UpdateText methods that hash wchar_t, char16_t and char32_t
+    strings as UTF-8 or UTF-16LE, transcoding directly into the block
+    buffer (SSE2 fast path for ASCII and BMP text).
+  - Added local hashing daemon, client library and load generator
+    (SHA1Daemon.h, POSIX only) that serve file path and memfd requests
+    over a Unix domain socket from one shared worker pool.
+  - Added CSHA256 (SHA256.h, SHA-NI accelerated if available) and a
+    multi-digest hasher (SHA1MultiHash.h) computing SHA-1, SHA-256 and
+    CRC32C from a single pass over the data.
+  - Added file copier (SHA1FileCopier.h) that hashes the data while
+    copying it, with pipelined reading, hashing and writing and optional
+    verification of the destination bypassing the cache.
+  - Added Linux kernel crypto API backend (SHA1KernelHash.h) that
+    splices file pages into an AF_ALG socket, with fallback to CSHA1 and
+    a benchmark comparing it with the user space implementation.
+  - HashFile reuses a page-aligned buffer arena (SHA1BufferArena.h)
+    instead of allocating a buffer per call, and sizes its reads to the
+    file size; small files are read into a stack buffer.
+  - Added asynchronous hashing of files and buffers (SHA1Async.h) on
+    library-owned I/O and compute threads, with C++20 awaitables,
+    std::future and callback variants and deferred completions for
+    event loops.
+  - Added progress callbacks, deadlines and cancellation tokens for the
+    file hashing functions (SHA1HashControl.h), checked once per chunk.
+  - Added opt-in statistics (SHA1Stats.h): per-thread counters of bytes,
+    blocks per kernel, read and hash time, file latency histograms and
+    buffer arena hits, with a Prometheus text dump.
+  - Added USDT tracepoints (SHA1Probes.h) for file open/close, chunk
+    reads and hashing, Final and kernel backend decisions.
+  - Added SaveState and LoadState methods that serialize the intermediate
+    state (versioned, endian-independent, CRC-32C protected), periodic
+    checkpoints of HashFile and ResumeHashFile to continue from one.
+  - Added incremental hashing of append-only files (SHA1TailHash.h) that
+    only reads the appended bytes and restarts on rotation or truncation;
+    its state can be saved to a file and loaded after a restart.
+  - HashFile skips the holes of sparse files (SEEK_DATA/SEEK_HOLE) and
+    hashes them as zeros without reading them.
+  - CSHA1HashCache can reuse the digest of a file with the same shared
+    extent map (FIEMAP) as an unchanged file hashed before in the same
+    run, e.g. a reflink copy, without reading it; the cache file format
+    is now version 2 (version 1 files are upgraded).
+  - Added parallel directory tree walker (SHA1TreeWalker.h) using
+    getdents64, statx and openat on Linux, with hard link detection,
+    that streams the files found into the asynchronous hasher.
+  - The file hashing functions moved to SHA1HashFile.cpp (C++11 or
+    later); SHA1.h and SHA1.cpp alone still build as C++98, with a plain
+    HashFile.
+
   Version 2.1 - 2012-06-19
   - Deconstructor (resetting internal variables) is now only
     implemented if SHA1_WIPE_VARIABLES is defined (which is the
@@ -132,6 +206,22 @@
 #include <stdlib.h>
 #endif
 
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+// C++11 is required for char16_t and char32_t (UpdateText overloads) and
+// for the instrumented file hashing (SHA1HashFile.cpp: buffer arena, hash
+// control, statistics); without it, SHA1.cpp alone provides a plain HashFile
+#if !defined(SHA1_HAS_CPP11) && ((__cplusplus >= 201103L) || \
+	(defined(_MSC_VER) && (_MSC_VER >= 1900)))
+#define SHA1_HAS_CPP11
+#endif
+
+#ifdef SHA1_HAS_CPP11
+#define SHA1_CHAR16_CHAR32
+#endif
+
 // You can define the endian mode in your files without modifying the SHA-1
 // source files. Just #define SHA1_LITTLE_ENDIAN or #define SHA1_BIG_ENDIAN
 // in your files, before including the SHA1.h header file. If you don't
@@ -209,6 +299,31 @@
 #endif // _MSC_VER
 #endif // UINT_64
 
+///////////////////////////////////////////////////////////////////////////
+// Scatter-gather element for UpdateV (struct iovec on POSIX systems)
+
+#ifdef _WIN32
+typedef struct
+{
+	void* iov_base;
+	size_t iov_len;
+} SHA1_IOVEC;
+#else
+typedef struct iovec SHA1_IOVEC;
+#endif
+
+class CSHA1BufferArena;
+class CSHA1HashControl;
+
+///////////////////////////////////////////////////////////////////////////
+// Serialized intermediate state (SaveState, LoadState), all fields
+// big-endian: magic "CSH1", version, 3 reserved bytes, 5 state words,
+// message length in bytes (64-bit), partial block (64 bytes, unused part
+// zero) and the CRC-32C of the preceding 100 bytes
+
+#define SHA1_STATE_SIZE 104
+#define SHA1_STATE_VERSION 1
+
 ///////////////////////////////////////////////////////////////////////////
 // Declare SHA-1 workspace
 
@@ -231,6 +346,13 @@ public:
 	};
 #endif
 
+	// Target encodings for UpdateText
+	enum TEXT_ENCODING
+	{
+		TEXT_UTF8 = 0,
+		TEXT_UTF16LE = 1
+	};
+
 	// Constructor and destructor
 	CSHA1();
 
@@ -243,11 +365,48 @@ public:
 	// Hash in binary data and strings
 	void Update(const UINT_8* pbData, UINT_32 uLen);
 
+	// Hash in a list of buffers as if they were one contiguous buffer
+	void UpdateV(const SHA1_IOVEC* pVec, size_t uCount);
+
+	// Hash in uLen code units of a wide string, transcoded to the chosen
+	// encoding on the fly (no temporary buffer). wchar_t is UTF-16 or
+	// UTF-32 depending on its size. Invalid code units are hashed as U+FFFD,
+	// except unpaired surrogates of UTF-16 input hashed as UTF-16LE.
+	void UpdateText(const wchar_t* pwData, size_t uLen, TEXT_ENCODING enc);
+#ifdef SHA1_CHAR16_CHAR32
+	void UpdateText(const char16_t* pData, size_t uLen, TEXT_ENCODING enc);
+	void UpdateText(const char32_t* pData, size_t uLen, TEXT_ENCODING enc);
+#endif
+
 #ifdef SHA1_UTILITY_FUNCTIONS
-	// Hash in file contents
-	bool HashFile(const TCHAR* tszFileName);
+	// Hash in file contents. The read buffer is taken from pArena, or from
+	// the calling thread's arena if pArena is NULL; small files are read
+	// into a stack buffer; holes of sparse files are not read. pControl
+	// (SHA1HashControl.h) optionally reports progress and cancels hashing
+	// between read chunks; checkpoints require that no data has been
+	// hashed in before (GetByteCount() == 0). Without SHA1_HAS_CPP11,
+	// pArena and pControl are ignored.
+	bool HashFile(const TCHAR* tszFileName, CSHA1BufferArena* pArena = NULL,
+		CSHA1HashControl* pControl = NULL);
+
+#ifdef SHA1_HAS_CPP11
+	// Continue hashing a file from a state saved by SaveState, usually a
+	// checkpoint of HashFile (see SHA1HashControl.h); the file is read
+	// from offset GetByteCount() of the restored state
+	bool ResumeHashFile(const TCHAR* tszFileName, const UINT_8* pbState, size_t uStateSize,
+		CSHA1BufferArena* pArena = NULL, CSHA1HashControl* pControl = NULL);
+#endif
 #endif
 
+	// Serialize the intermediate state (before Final) into SHA1_STATE_SIZE
+	// bytes, independent of the platform. LoadState returns false if the
+	// data is damaged or has an unknown version; the object is unchanged then.
+	bool SaveState(UINT_8* pbDest, size_t uDestSize) const;
+	bool LoadState(const UINT_8* pbSrc, size_t uSrcSize);
+
+	// Number of message bytes hashed in so far
+	UINT_64 GetByteCount() const;
+
 	// Finalize hash; call it before using ReportHash(Stl)
 	void Final();
 
@@ -267,6 +426,15 @@ private:
 	// Private SHA-1 transformation
 	void Transform(UINT_32* pState, const UINT_8* pBuffer);
 
+	template<typename T> void UpdateUtf16(const T* pData, size_t uLen, TEXT_ENCODING enc);
+	template<typename T> void UpdateUtf32(const T* pData, size_t uLen, TEXT_ENCODING enc);
+	void AddByteCount(UINT_64 uBytes);
+
+#if defined(SHA1_UTILITY_FUNCTIONS) && defined(SHA1_HAS_CPP11)
+	bool HashFileFrom(const TCHAR* tszFileName, UINT_64 uOffset, CSHA1BufferArena* pArena,
+		CSHA1HashControl* pControl);
+#endif
+
 	// Member variables
 	UINT_32 m_state[5];
 	UINT_32 m_count[2];
@@ -0,0 +1,276 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#include "SHA1Async.h"
+
+namespace
+{
+	// Heap-allocated request for the callback and future variants
+	class CSHA1AsyncCallbackRequest : public CSHA1AsyncRequest
+	{
+	public:
+		explicit CSHA1AsyncCallbackRequest(const SHA1_ASYNC_CALLBACK& fnCallback) :
+			m_fnCallback(fnCallback) { }
+
+	protected:
+		void OnComplete()
+		{
+			if(m_fnCallback) m_fnCallback(GetResult());
+			delete this;
+		}
+
+	private:
+		SHA1_ASYNC_CALLBACK m_fnCallback;
+	};
+
+	class CSHA1AsyncPromiseRequest : public CSHA1AsyncRequest
+	{
+	public:
+		std::future<SHA1_ASYNC_RESULT> GetFuture() { return m_promise.get_future(); }
+
+	protected:
+		void OnComplete()
+		{
+			m_promise.set_value(GetResult());
+			delete this;
+		}
+
+	private:
+		std::promise<SHA1_ASYNC_RESULT> m_promise;
+	};
+}
+
+CSHA1AsyncRequest::CSHA1AsyncRequest() :
+	m_tszFileName(NULL), m_pControl(NULL), m_pbData(NULL), m_uLen(0), m_pNext(NULL)
+{
+	m_result.bSuccess = false;
+}
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+void CSHA1AsyncRequest::SetFile(const TCHAR* tszFileName, CSHA1HashControl* pControl)
+{
+	m_tszFileName = tszFileName;
+	m_pControl = pControl;
+	m_pbData = NULL;
+	m_uLen = 0;
+}
+#endif
+
+void CSHA1AsyncRequest::SetBuffer(const void* pData, size_t uLen)
+{
+	m_tszFileName = NULL;
+	m_pControl = NULL;
+	m_pbData = static_cast<const UINT_8*>(pData);
+	m_uLen = ((pData != NULL) ? uLen : 0);
+}
+
+CSHA1AsyncHasher::CSHA1AsyncHasher(size_t uIoThreads, size_t uComputeThreads) :
+	m_uOutstanding(0), m_bStop(false), m_bDeferred(false)
+{
+	m_qFiles.pHead = m_qFiles.pTail = NULL;
+	m_qBuffers.pHead = m_qBuffers.pTail = NULL;
+	m_qCompleted.pHead = m_qCompleted.pTail = NULL;
+
+	if(uIoThreads == 0) uIoThreads = SHA1_ASYNC_IO_THREADS;
+	if(uComputeThreads == 0) uComputeThreads = std::thread::hardware_concurrency();
+	if(uComputeThreads == 0) uComputeThreads = 1;
+
+	for(size_t i = 0; i < uIoThreads; ++i)
+		m_vThreads.push_back(std::thread(&CSHA1AsyncHasher::WorkerMain, this, true));
+	for(size_t i = 0; i < uComputeThreads; ++i)
+		m_vThreads.push_back(std::thread(&CSHA1AsyncHasher::WorkerMain, this, false));
+}
+
+CSHA1AsyncHasher::~CSHA1AsyncHasher()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_bStop = true;
+	}
+	m_cvFiles.notify_all();
+	m_cvBuffers.notify_all();
+
+	for(size_t i = 0; i < m_vThreads.size(); ++i)
+		m_vThreads[i].join();
+
+	DispatchCompletions();
+}
+
+void CSHA1AsyncHasher::QueuePush(SHA1_ASYNC_QUEUE& q, CSHA1AsyncRequest* pRequest)
+{
+	pRequest->m_pNext = NULL;
+	if(q.pTail != NULL) q.pTail->m_pNext = pRequest;
+	else q.pHead = pRequest;
+	q.pTail = pRequest;
+}
+
+CSHA1AsyncRequest* CSHA1AsyncHasher::QueuePop(SHA1_ASYNC_QUEUE& q)
+{
+	CSHA1AsyncRequest* pRequest = q.pHead;
+	if(pRequest == NULL) return NULL;
+
+	q.pHead = pRequest->m_pNext;
+	if(q.pHead == NULL) q.pTail = NULL;
+	pRequest->m_pNext = NULL;
+	return pRequest;
+}
+
+void CSHA1AsyncHasher::Submit(CSHA1AsyncRequest* pRequest)
+{
+	if(pRequest == NULL) return;
+
+	const bool bFile = (pRequest->m_tszFileName != NULL);
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		QueuePush(bFile ? m_qFiles : m_qBuffers, pRequest);
+		++m_uOutstanding;
+	}
+
+	if(bFile) m_cvFiles.notify_one();
+	else m_cvBuffers.notify_one();
+}
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+void CSHA1AsyncHasher::HashFile(const TCHAR* tszFileName, const SHA1_ASYNC_CALLBACK& fnCallback,
+	CSHA1HashControl* pControl)
+{
+	CSHA1AsyncCallbackRequest* pRequest = new CSHA1AsyncCallbackRequest(fnCallback);
+	pRequest->SetFile(tszFileName, pControl);
+	Submit(pRequest);
+}
+
+std::future<SHA1_ASYNC_RESULT> CSHA1AsyncHasher::HashFileAsync(const TCHAR* tszFileName,
+	CSHA1HashControl* pControl)
+{
+	CSHA1AsyncPromiseRequest* pRequest = new CSHA1AsyncPromiseRequest();
+	pRequest->SetFile(tszFileName, pControl);
+
+	std::future<SHA1_ASYNC_RESULT> f = pRequest->GetFuture();
+	Submit(pRequest);
+	return f;
+}
+#endif
+
+void CSHA1AsyncHasher::HashBuffer(const void* pData, size_t uLen,
+	const SHA1_ASYNC_CALLBACK& fnCallback)
+{
+	CSHA1AsyncCallbackRequest* pRequest = new CSHA1AsyncCallbackRequest(fnCallback);
+	pRequest->SetBuffer(pData, uLen);
+	Submit(pRequest);
+}
+
+std::future<SHA1_ASYNC_RESULT> CSHA1AsyncHasher::HashBufferAsync(const void* pData, size_t uLen)
+{
+	CSHA1AsyncPromiseRequest* pRequest = new CSHA1AsyncPromiseRequest();
+	pRequest->SetBuffer(pData, uLen);
+
+	std::future<SHA1_ASYNC_RESULT> f = pRequest->GetFuture();
+	Submit(pRequest);
+	return f;
+}
+
+void CSHA1AsyncHasher::SetDeferredCompletions(const std::function<void()>& fnNotify)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_bDeferred = true;
+	m_fnNotify = fnNotify;
+}
+
+size_t CSHA1AsyncHasher::DispatchCompletions()
+{
+	SHA1_ASYNC_QUEUE q;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		q = m_qCompleted;
+		m_qCompleted.pHead = m_qCompleted.pTail = NULL;
+	}
+
+	size_t uCount = 0;
+	CSHA1AsyncRequest* pRequest;
+	while((pRequest = QueuePop(q)) != NULL)
+	{
+		pRequest->OnComplete();
+		++uCount;
+	}
+
+	return uCount;
+}
+
+void CSHA1AsyncHasher::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	while(m_uOutstanding != 0) m_cvIdle.wait(lock);
+}
+
+CSHA1AsyncHasher& CSHA1AsyncHasher::GetDefault()
+{
+	static CSHA1AsyncHasher s_hasher;
+	return s_hasher;
+}
+
+void CSHA1AsyncHasher::WorkerMain(bool bIo)
+{
+	SHA1_ASYNC_QUEUE& q = (bIo ? m_qFiles : m_qBuffers);
+	std::condition_variable& cv = (bIo ? m_cvFiles : m_cvBuffers);
+
+	while(true)
+	{
+		CSHA1AsyncRequest* pRequest;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			while(!m_bStop && (q.pHead == NULL)) cv.wait(lock);
+
+			pRequest = QueuePop(q);
+			if(pRequest == NULL) return; // Stopping and drained
+		}
+
+		Process(pRequest);
+		Complete(pRequest);
+	}
+}
+
+void CSHA1AsyncHasher::Process(CSHA1AsyncRequest* pRequest)
+{
+	CSHA1 sha1;
+	bool bSuccess = true;
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+	if(pRequest->m_tszFileName != NULL)
+		bSuccess = sha1.HashFile(pRequest->m_tszFileName, NULL, // Uses the thread's arena
+			pRequest->m_pControl);
+	else
+#endif
+	{
+		SHA1_IOVEC v;
+		v.iov_base = const_cast<UINT_8*>(pRequest->m_pbData);
+		v.iov_len = pRequest->m_uLen;
+		sha1.UpdateV(&v, 1);
+	}
+
+	sha1.Final();
+	pRequest->m_result.bSuccess = bSuccess;
+	if(bSuccess) pRequest->m_result.digest = CSHA1Digest(sha1);
+	else pRequest->m_result.digest = CSHA1Digest();
+}
+
+void CSHA1AsyncHasher::Complete(CSHA1AsyncRequest* pRequest)
+{
+	bool bNotify = false;
+	if(m_bDeferred)
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		bNotify = (m_qCompleted.pHead == NULL);
+		QueuePush(m_qCompleted, pRequest);
+	}
+	else pRequest->OnComplete(); // pRequest may be gone afterwards
+
+	if(bNotify && m_fnNotify) m_fnNotify();
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if(--m_uOutstanding == 0) m_cvIdle.notify_all();
+}
@@ -0,0 +1,211 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Asynchronous hashing of files and buffers. See SHA1.h for version
+  history.
+
+  CSHA1AsyncHasher owns two sets of threads: I/O threads that read and
+  hash files, and compute threads that hash buffers already in memory.
+  Each I/O thread reads through its own buffer arena, so the memory used
+  for I/O is bounded by the number of I/O threads, independent of the
+  number of outstanding requests.
+
+  Requests are intrusive (CSHA1AsyncRequest): queuing one does not
+  allocate. The coroutine awaitables (C++20) are such requests living in
+  the coroutine frame, so thousands of suspended coroutines cost the
+  library nothing but their queue links:
+
+    SHA1_ASYNC_RESULT r = co_await hasher.AwaitFile(tszPath);
+
+  The std::future and callback variants allocate one small request each.
+
+  Completions run on the worker thread by default. An event loop can
+  instead request deferred completions: the notify function is invoked
+  when completions become available (e.g. to signal an eventfd or post
+  to the loop), and the loop calls DispatchCompletions, which resumes
+  coroutines and invokes callbacks on the loop thread.
+
+  File names, buffers and hash controls (SHA1HashControl.h) must stay
+  valid until the request completes. A control must not be shared by
+  concurrent requests; cancel tokens can be.
+*/
+
+#ifndef SHA1ASYNC_H_5E8A1C3F7B2D4E69A0C6F4B8D2E7A1F3
+#define SHA1ASYNC_H_5E8A1C3F7B2D4E69A0C6F4B8D2E7A1F3
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SHA1.h"
+#include "SHA1Digest.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define SHA1_ASYNC_COROUTINES
+#endif
+#endif
+
+#ifndef SHA1_ASYNC_IO_THREADS
+#define SHA1_ASYNC_IO_THREADS 4
+#endif
+
+typedef struct
+{
+	bool bSuccess; // False if the file could not be read or hashing was cancelled
+	CSHA1Digest digest;
+} SHA1_ASYNC_RESULT;
+
+typedef std::function<void(const SHA1_ASYNC_RESULT&)> SHA1_ASYNC_CALLBACK;
+
+class CSHA1AsyncHasher;
+
+class CSHA1AsyncRequest
+{
+public:
+	CSHA1AsyncRequest();
+	virtual ~CSHA1AsyncRequest() { }
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+	// pControl: see CSHA1::HashFile
+	void SetFile(const TCHAR* tszFileName, CSHA1HashControl* pControl = NULL);
+#endif
+	void SetBuffer(const void* pData, size_t uLen);
+
+	const SHA1_ASYNC_RESULT& GetResult() const { return m_result; }
+
+protected:
+	// Invoked once when the request has been processed; the request may
+	// be destroyed within this function
+	virtual void OnComplete() = 0;
+
+private:
+	friend class CSHA1AsyncHasher;
+
+	CSHA1AsyncRequest(const CSHA1AsyncRequest&);
+	CSHA1AsyncRequest& operator=(const CSHA1AsyncRequest&);
+
+	const TCHAR* m_tszFileName;
+	CSHA1HashControl* m_pControl;
+	const UINT_8* m_pbData;
+	size_t m_uLen;
+	SHA1_ASYNC_RESULT m_result;
+	CSHA1AsyncRequest* m_pNext;
+};
+
+#ifdef SHA1_ASYNC_COROUTINES
+class CSHA1AsyncAwaitable : public CSHA1AsyncRequest
+{
+public:
+#ifdef SHA1_UTILITY_FUNCTIONS
+	CSHA1AsyncAwaitable(CSHA1AsyncHasher* pHasher, const TCHAR* tszFileName,
+		CSHA1HashControl* pControl) : m_pHasher(pHasher) { SetFile(tszFileName, pControl); }
+#endif
+	CSHA1AsyncAwaitable(CSHA1AsyncHasher* pHasher, const void* pData, size_t uLen) :
+		m_pHasher(pHasher) { SetBuffer(pData, uLen); }
+
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> hCoroutine);
+	SHA1_ASYNC_RESULT await_resume() const noexcept { return GetResult(); }
+
+protected:
+	void OnComplete() { m_hCoroutine.resume(); }
+
+private:
+	CSHA1AsyncHasher* m_pHasher;
+	std::coroutine_handle<> m_hCoroutine;
+};
+#endif
+
+class CSHA1AsyncHasher
+{
+public:
+	// If uIoThreads is 0, SHA1_ASYNC_IO_THREADS are created; if
+	// uComputeThreads is 0, one per hardware thread
+	CSHA1AsyncHasher(size_t uIoThreads = 0, size_t uComputeThreads = 0);
+	~CSHA1AsyncHasher(); // Completes all submitted requests
+
+	// The request must stay valid until its OnComplete has been invoked
+	void Submit(CSHA1AsyncRequest* pRequest);
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+	void HashFile(const TCHAR* tszFileName, const SHA1_ASYNC_CALLBACK& fnCallback,
+		CSHA1HashControl* pControl = NULL);
+	std::future<SHA1_ASYNC_RESULT> HashFileAsync(const TCHAR* tszFileName,
+		CSHA1HashControl* pControl = NULL);
+#endif
+	void HashBuffer(const void* pData, size_t uLen, const SHA1_ASYNC_CALLBACK& fnCallback);
+	std::future<SHA1_ASYNC_RESULT> HashBufferAsync(const void* pData, size_t uLen);
+
+#ifdef SHA1_ASYNC_COROUTINES
+	// Awaitables are neither copyable nor movable; await them directly
+#ifdef SHA1_UTILITY_FUNCTIONS
+	CSHA1AsyncAwaitable AwaitFile(const TCHAR* tszFileName, CSHA1HashControl* pControl = NULL)
+		{ return CSHA1AsyncAwaitable(this, tszFileName, pControl); }
+#endif
+	CSHA1AsyncAwaitable AwaitBuffer(const void* pData, size_t uLen)
+		{ return CSHA1AsyncAwaitable(this, pData, uLen); }
+#endif
+
+	// Must be called before submitting requests. fnNotify is invoked on a
+	// worker thread whenever the completion queue becomes non-empty.
+	void SetDeferredCompletions(const std::function<void()>& fnNotify);
+
+	// Runs the queued completions on the calling thread; returns how many
+	size_t DispatchCompletions();
+
+	// Wait until all requests submitted so far have been processed
+	// (deferred completions may still be waiting to be dispatched)
+	void Wait();
+
+	// Shared instance, created on first use
+	static CSHA1AsyncHasher& GetDefault();
+
+private:
+	typedef struct
+	{
+		CSHA1AsyncRequest* pHead;
+		CSHA1AsyncRequest* pTail;
+	} SHA1_ASYNC_QUEUE;
+
+	static void QueuePush(SHA1_ASYNC_QUEUE& q, CSHA1AsyncRequest* pRequest);
+	static CSHA1AsyncRequest* QueuePop(SHA1_ASYNC_QUEUE& q);
+
+	void WorkerMain(bool bIo);
+	void Process(CSHA1AsyncRequest* pRequest);
+	void Complete(CSHA1AsyncRequest* pRequest);
+
+	CSHA1AsyncHasher(const CSHA1AsyncHasher&);
+	CSHA1AsyncHasher& operator=(const CSHA1AsyncHasher&);
+
+	std::vector<std::thread> m_vThreads;
+	SHA1_ASYNC_QUEUE m_qFiles;
+	SHA1_ASYNC_QUEUE m_qBuffers;
+	SHA1_ASYNC_QUEUE m_qCompleted;
+	size_t m_uOutstanding;
+	bool m_bStop;
+
+	bool m_bDeferred;
+	std::function<void()> m_fnNotify;
+
+	std::mutex m_mtx;
+	std::condition_variable m_cvFiles;
+	std::condition_variable m_cvBuffers;
+	std::condition_variable m_cvIdle;
+};
+
+#ifdef SHA1_ASYNC_COROUTINES
+inline void CSHA1AsyncAwaitable::await_suspend(std::coroutine_handle<> hCoroutine)
+{
+	m_hCoroutine = hCoroutine;
+	m_pHasher->Submit(this); // May resume the coroutine before returning
+}
+#endif
+
+#endif // SHA1ASYNC_H_5E8A1C3F7B2D4E69A0C6F4B8D2E7A1F3
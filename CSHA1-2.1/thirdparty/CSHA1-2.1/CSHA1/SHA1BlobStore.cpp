@@ -0,0 +1,399 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1BlobStore.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define SHA1_PATH_SEP _T('\\')
+#define SHA1_BLOB_NO_FILE INVALID_HANDLE_VALUE
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SHA1_PATH_SEP _T('/')
+#define SHA1_BLOB_NO_FILE (-1)
+#endif
+
+#include <atomic>
+
+typedef std::basic_string<TCHAR> SHA1_TSTRING;
+
+static void SHA1BlobHex(const UINT_8* pbData, size_t uLen, TCHAR* tszOut)
+{
+	static const char* const pszHex = "0123456789abcdef";
+
+	for(size_t i = 0; i < uLen; ++i)
+	{
+		tszOut[i << 1] = static_cast<TCHAR>(pszHex[pbData[i] >> 4]);
+		tszOut[(i << 1) + 1] = static_cast<TCHAR>(pszHex[pbData[i] & 0x0F]);
+	}
+	tszOut[uLen << 1] = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Platform helpers
+
+#ifdef _WIN32
+
+static bool SHA1BlobMkDir(const SHA1_TSTRING& strDir)
+{
+	if(CreateDirectory(strDir.c_str(), NULL) != FALSE) return true;
+	return (GetLastError() == ERROR_ALREADY_EXISTS);
+}
+
+static bool SHA1BlobExists(const SHA1_TSTRING& strPath)
+{
+	return (GetFileAttributes(strPath.c_str()) != INVALID_FILE_ATTRIBUTES);
+}
+
+static bool SHA1BlobRemove(const SHA1_TSTRING& strPath)
+{
+	return (DeleteFile(strPath.c_str()) != FALSE);
+}
+
+static bool SHA1BlobSyncDir(const SHA1_TSTRING&)
+{
+	return true; // MoveFileEx with MOVEFILE_WRITE_THROUGH flushes the move
+}
+
+// Returns false if strTo exists already or the move failed
+static bool SHA1BlobMoveNoReplace(const SHA1_TSTRING& strFrom, const SHA1_TSTRING& strTo,
+	bool& bExisted)
+{
+	bExisted = false;
+	if(MoveFileEx(strFrom.c_str(), strTo.c_str(), MOVEFILE_WRITE_THROUGH) != FALSE)
+		return true;
+
+	const DWORD dwError = GetLastError();
+	bExisted = ((dwError == ERROR_ALREADY_EXISTS) || (dwError == ERROR_FILE_EXISTS));
+	return false;
+}
+
+static bool SHA1BlobCreateTemp(const SHA1_TSTRING& strTempDir, SHA1_TSTRING& strPath,
+	HANDLE& hFile)
+{
+	static std::atomic<UINT_32> s_uCounter(0);
+
+	for(int iTry = 0; iTry < 16; ++iTry)
+	{
+		TCHAR tszName[64];
+		_sntprintf(tszName, 63, _T("%lu-%lu-%lu.tmp"),
+			static_cast<unsigned long>(GetCurrentProcessId()),
+			static_cast<unsigned long>(GetCurrentThreadId()),
+			static_cast<unsigned long>(s_uCounter++));
+		tszName[63] = 0;
+
+		strPath = strTempDir + SHA1_PATH_SEP + tszName;
+		hFile = CreateFile(strPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW,
+			FILE_ATTRIBUTE_TEMPORARY, NULL);
+		if(hFile != INVALID_HANDLE_VALUE) return true;
+	}
+
+	strPath.clear();
+	return false;
+}
+
+static bool SHA1BlobWriteAll(HANDLE hFile, const UINT_8* pbData, size_t uLen)
+{
+	while(uLen != 0)
+	{
+		const DWORD dwPart = static_cast<DWORD>((uLen > 0x40000000) ? 0x40000000 : uLen);
+		DWORD dwWritten = 0;
+		if(WriteFile(hFile, pbData, dwPart, &dwWritten, NULL) == FALSE) return false;
+		if(dwWritten == 0) return false;
+
+		pbData += dwWritten;
+		uLen -= dwWritten;
+	}
+
+	return true;
+}
+
+static bool SHA1BlobCloseFile(HANDLE hFile, bool bSync)
+{
+	bool bResult = true;
+	if(bSync) bResult = (FlushFileBuffers(hFile) != FALSE);
+	if(CloseHandle(hFile) == FALSE) bResult = false;
+	return bResult;
+}
+
+#else // !_WIN32
+
+static bool SHA1BlobMkDir(const SHA1_TSTRING& strDir)
+{
+	if(mkdir(strDir.c_str(), 0755) == 0) return true;
+	return (errno == EEXIST);
+}
+
+static bool SHA1BlobExists(const SHA1_TSTRING& strPath)
+{
+	struct stat st;
+	return (stat(strPath.c_str(), &st) == 0);
+}
+
+static bool SHA1BlobRemove(const SHA1_TSTRING& strPath)
+{
+	return (unlink(strPath.c_str()) == 0);
+}
+
+static bool SHA1BlobSyncDir(const SHA1_TSTRING& strDir)
+{
+	const int fd = open(strDir.c_str(), O_RDONLY | O_DIRECTORY);
+	if(fd < 0) return false;
+
+	const bool bResult = (fsync(fd) == 0);
+	close(fd);
+	return bResult;
+}
+
+// Returns false if strTo exists already or the move failed
+static bool SHA1BlobMoveNoReplace(const SHA1_TSTRING& strFrom, const SHA1_TSTRING& strTo,
+	bool& bExisted)
+{
+	bExisted = false;
+
+	// link() never replaces an existing blob
+	if(link(strFrom.c_str(), strTo.c_str()) == 0)
+	{
+		unlink(strFrom.c_str());
+		return true;
+	}
+
+	if(errno == EEXIST) { bExisted = true; return false; }
+
+	// File system without hard link support; blobs with the same name
+	// have the same content, so replacing one is harmless
+	return (rename(strFrom.c_str(), strTo.c_str()) == 0);
+}
+
+static bool SHA1BlobCreateTemp(const SHA1_TSTRING& strTempDir, SHA1_TSTRING& strPath,
+	int& fd)
+{
+	strPath = strTempDir + SHA1_PATH_SEP + _T("blob-XXXXXX");
+	fd = mkstemp(&strPath[0]);
+	if(fd >= 0) return true;
+
+	strPath.clear();
+	return false;
+}
+
+static bool SHA1BlobWriteAll(int fd, const UINT_8* pbData, size_t uLen)
+{
+	while(uLen != 0)
+	{
+		const ssize_t nWritten = write(fd, pbData, uLen);
+		if(nWritten < 0)
+		{
+			if(errno == EINTR) continue;
+			return false;
+		}
+
+		pbData += nWritten;
+		uLen -= static_cast<size_t>(nWritten);
+	}
+
+	return true;
+}
+
+static bool SHA1BlobCloseFile(int fd, bool bSync)
+{
+	bool bResult = true;
+	if(bSync) bResult = (fsync(fd) == 0);
+	if(close(fd) != 0) bResult = false;
+	return bResult;
+}
+
+#endif // _WIN32
+
+///////////////////////////////////////////////////////////////////////////
+// CSHA1BlobStore
+
+CSHA1BlobStore::CSHA1BlobStore() :
+	m_bSync(true)
+{
+}
+
+bool CSHA1BlobStore::Open(const TCHAR* tszRootDir, bool bSync)
+{
+	if((tszRootDir == NULL) || (tszRootDir[0] == 0)) return false;
+
+	m_strRoot = tszRootDir;
+	m_bSync = bSync;
+
+	if(!SHA1BlobMkDir(m_strRoot)) return false;
+	if(!SHA1BlobMkDir(m_strRoot + SHA1_PATH_SEP + _T("tmp"))) return false;
+	return SHA1BlobMkDir(m_strRoot + SHA1_PATH_SEP + _T("objects"));
+}
+
+SHA1_TSTRING CSHA1BlobStore::GetBlobDir(const UINT_8* pbHash20) const
+{
+	TCHAR tszHex[3];
+	SHA1BlobHex(pbHash20, 1, tszHex);
+
+	return (m_strRoot + SHA1_PATH_SEP + _T("objects") + SHA1_PATH_SEP + tszHex);
+}
+
+SHA1_TSTRING CSHA1BlobStore::GetBlobPath(const UINT_8* pbHash20) const
+{
+	if(pbHash20 == NULL) return SHA1_TSTRING();
+
+	TCHAR tszHex[41];
+	SHA1BlobHex(pbHash20, 20, tszHex);
+
+	return (GetBlobDir(pbHash20) + SHA1_PATH_SEP + &tszHex[2]);
+}
+
+bool CSHA1BlobStore::Contains(const UINT_8* pbHash20) const
+{
+	if(pbHash20 == NULL) return false;
+	return SHA1BlobExists(GetBlobPath(pbHash20));
+}
+
+bool CSHA1BlobStore::Put(const UINT_8* pbData, size_t uLen, UINT_8* pbHash20Out,
+	bool* pbExisted)
+{
+	if((pbData == NULL) && (uLen != 0)) return false;
+	if(pbHash20Out == NULL) return false;
+
+	SHA1_IOVEC vec;
+	vec.iov_base = const_cast<UINT_8*>(pbData);
+	vec.iov_len = uLen;
+
+	CSHA1 sha1;
+	sha1.UpdateV(&vec, 1);
+	sha1.Final();
+	sha1.GetHash(pbHash20Out);
+
+	if(Contains(pbHash20Out))
+	{
+		if(pbExisted != NULL) *pbExisted = true;
+		return true;
+	}
+
+	CSHA1BlobWriter w;
+	if(!w.Begin(*this)) return false;
+	if(!w.Write(pbData, uLen)) return false;
+	return w.Commit(pbHash20Out, pbExisted);
+}
+
+bool CSHA1BlobStore::Get(const UINT_8* pbHash20, CSHA1MappedFile& mfOut, bool bVerify) const
+{
+	if(pbHash20 == NULL) return false;
+	if(!mfOut.Open(GetBlobPath(pbHash20).c_str())) return false;
+
+	if(bVerify)
+	{
+		SHA1_IOVEC vec;
+		vec.iov_base = const_cast<UINT_8*>(mfOut.GetData());
+		vec.iov_len = static_cast<size_t>(mfOut.GetSize());
+
+		CSHA1 sha1;
+		sha1.UpdateV(&vec, 1);
+		sha1.Final();
+
+		UINT_8 pbHash[20];
+		sha1.GetHash(pbHash);
+		if(memcmp(pbHash, pbHash20, 20) != 0) { mfOut.Close(); return false; }
+	}
+
+	return true;
+}
+
+bool CSHA1BlobStore::Remove(const UINT_8* pbHash20)
+{
+	if(pbHash20 == NULL) return false;
+	return SHA1BlobRemove(GetBlobPath(pbHash20));
+}
+
+///////////////////////////////////////////////////////////////////////////
+// CSHA1BlobWriter
+
+CSHA1BlobWriter::CSHA1BlobWriter() :
+	m_pStore(NULL), m_hFile(SHA1_BLOB_NO_FILE)
+{
+}
+
+CSHA1BlobWriter::~CSHA1BlobWriter()
+{
+	Abort();
+}
+
+bool CSHA1BlobWriter::Begin(CSHA1BlobStore& store)
+{
+	Abort();
+
+	if(!SHA1BlobCreateTemp(store.m_strRoot + SHA1_PATH_SEP + _T("tmp"), m_strTemp, m_hFile))
+		return false;
+
+	m_pStore = &store;
+	m_sha1.Reset();
+	return true;
+}
+
+bool CSHA1BlobWriter::Write(const UINT_8* pbData, size_t uLen)
+{
+	if(m_pStore == NULL) return false;
+	if((pbData == NULL) && (uLen != 0)) return false;
+
+	SHA1_IOVEC vec;
+	vec.iov_base = const_cast<UINT_8*>(pbData);
+	vec.iov_len = uLen;
+	m_sha1.UpdateV(&vec, 1);
+
+	if(!SHA1BlobWriteAll(m_hFile, pbData, uLen)) { Abort(); return false; }
+	return true;
+}
+
+bool CSHA1BlobWriter::Commit(UINT_8* pbHash20Out, bool* pbExisted)
+{
+	if((m_pStore == NULL) || (pbHash20Out == NULL)) return false;
+
+	m_sha1.Final();
+	m_sha1.GetHash(pbHash20Out);
+
+	// Flushing is pointless if the blob is going to be discarded
+	const bool bSync = (m_pStore->m_bSync && !m_pStore->Contains(pbHash20Out));
+	const bool bClosed = SHA1BlobCloseFile(m_hFile, bSync);
+	m_hFile = SHA1_BLOB_NO_FILE;
+	if(!bClosed) { Abort(); return false; }
+
+	const SHA1_TSTRING strDir = m_pStore->GetBlobDir(pbHash20Out);
+	if(!SHA1BlobMkDir(strDir)) { Abort(); return false; }
+
+	bool bExisted = false;
+	const bool bMoved = SHA1BlobMoveNoReplace(m_strTemp,
+		m_pStore->GetBlobPath(pbHash20Out), bExisted);
+	if(pbExisted != NULL) *pbExisted = bExisted;
+
+	if(!bMoved)
+	{
+		Abort(); // Removes the temporary file
+		return bExisted;
+	}
+
+	if(bSync) SHA1BlobSyncDir(strDir);
+
+	m_strTemp.clear();
+	m_pStore = NULL;
+	return true;
+}
+
+void CSHA1BlobWriter::Abort()
+{
+	if(m_hFile != SHA1_BLOB_NO_FILE) SHA1BlobCloseFile(m_hFile, false);
+	m_hFile = SHA1_BLOB_NO_FILE;
+
+	if(!m_strTemp.empty()) SHA1BlobRemove(m_strTemp);
+	m_strTemp.clear();
+	m_pStore = NULL;
+}
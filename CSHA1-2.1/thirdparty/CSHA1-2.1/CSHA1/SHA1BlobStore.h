@@ -0,0 +1,88 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Local content-addressable blob store keyed by SHA-1 digests.
+  See SHA1.h for version history.
+
+  Layout of the store directory:
+    tmp/                 Blobs that are currently being written
+    objects/xx/yyyy...   Blobs; xx are the first 2 hex digits of the digest
+
+  Writers stream data into a private temporary file while hashing it and
+  move it into place when committing; a blob that already exists is not
+  written again. No global lock is used, so any number of writers (also
+  in different processes) can work concurrently. Blobs are read through
+  a memory mapping and can optionally be re-verified.
+*/
+
+#ifndef SHA1BLOBSTORE_H_588EAB403090487986B14ACDD5E7D525
+#define SHA1BLOBSTORE_H_588EAB403090487986B14ACDD5E7D525
+
+#include <string>
+
+#include "SHA1.h"
+#include "SHA1MappedFile.h"
+
+class CSHA1BlobStore
+{
+public:
+	CSHA1BlobStore();
+
+	// Opens (and creates, if necessary) a store. If bSync is true, blobs
+	// and directory entries are flushed to disk before a commit returns.
+	bool Open(const TCHAR* tszRootDir, bool bSync = true);
+
+	bool Contains(const UINT_8* pbHash20) const;
+
+	// Hashes the buffer first and writes it only if it is not stored yet
+	bool Put(const UINT_8* pbData, size_t uLen, UINT_8* pbHash20Out,
+		bool* pbExisted = NULL);
+
+	// Maps a blob; if bVerify is true, the data is hashed and compared
+	bool Get(const UINT_8* pbHash20, CSHA1MappedFile& mfOut, bool bVerify = false) const;
+
+	bool Remove(const UINT_8* pbHash20);
+
+	std::basic_string<TCHAR> GetBlobPath(const UINT_8* pbHash20) const;
+
+private:
+	friend class CSHA1BlobWriter;
+
+	std::basic_string<TCHAR> GetBlobDir(const UINT_8* pbHash20) const;
+
+	std::basic_string<TCHAR> m_strRoot;
+	bool m_bSync;
+};
+
+class CSHA1BlobWriter
+{
+public:
+	CSHA1BlobWriter();
+	~CSHA1BlobWriter(); // Aborts an uncommitted blob
+
+	bool Begin(CSHA1BlobStore& store);
+	bool Write(const UINT_8* pbData, size_t uLen);
+
+	// Moves the blob into the store (or discards it, if a blob with the
+	// same digest exists already) and returns its digest
+	bool Commit(UINT_8* pbHash20Out, bool* pbExisted = NULL);
+	void Abort();
+
+private:
+	CSHA1BlobWriter(const CSHA1BlobWriter&);
+	CSHA1BlobWriter& operator=(const CSHA1BlobWriter&);
+
+	CSHA1BlobStore* m_pStore;
+	CSHA1 m_sha1;
+	std::basic_string<TCHAR> m_strTemp;
+
+#ifdef _WIN32
+	void* m_hFile;
+#else
+	int m_hFile;
+#endif
+};
+
+#endif // SHA1BLOBSTORE_H_588EAB403090487986B14ACDD5E7D525
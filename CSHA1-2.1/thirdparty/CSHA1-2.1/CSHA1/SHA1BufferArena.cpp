@@ -0,0 +1,115 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#include "SHA1BufferArena.h"
+#include "SHA1Stats.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// Buffers grow in steps of this size (a multiple of the page size)
+#define SHA1_ARENA_GRANULARITY (64 * 1024)
+
+#define SHA1_ARENA_HUGE_PAGE (2 * 1024 * 1024)
+
+static size_t SHA1ArenaRoundUp(size_t uSize, size_t uStep)
+{
+	return ((uSize + (uStep - 1)) / uStep) * uStep;
+}
+
+CSHA1BufferArena::CSHA1BufferArena(bool bHugePages) :
+	m_pbBuffer(NULL), m_uCapacity(0), m_bHugePages(bHugePages), m_bMappedHuge(false)
+{
+}
+
+CSHA1BufferArena::~CSHA1BufferArena()
+{
+	Release();
+}
+
+UINT_8* CSHA1BufferArena::Acquire(size_t uMinSize)
+{
+	if(uMinSize == 0) uMinSize = 1;
+
+	const bool bHit = ((m_pbBuffer != NULL) && (uMinSize <= m_uCapacity));
+	if(SHA1StatsEnabled()) SHA1StatsAddArena(bHit);
+	if(bHit) return m_pbBuffer;
+
+	Release();
+
+	const bool bHuge = (m_bHugePages && (uMinSize >= SHA1_ARENA_HUGE_PAGE));
+	size_t uSize = SHA1ArenaRoundUp(uMinSize, (bHuge ? SHA1_ARENA_HUGE_PAGE :
+		SHA1_ARENA_GRANULARITY));
+	void* pMem = NULL;
+
+#ifdef _WIN32
+	if(bHuge)
+	{
+		const SIZE_T uLarge = GetLargePageMinimum();
+		if(uLarge != 0)
+		{
+			const size_t uLargeSize = SHA1ArenaRoundUp(uSize, uLarge);
+			pMem = VirtualAlloc(NULL, uLargeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+				PAGE_READWRITE);
+			if(pMem != NULL) { uSize = uLargeSize; m_bMappedHuge = true; }
+		}
+	}
+
+	if(pMem == NULL) pMem = VirtualAlloc(NULL, uSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+#ifdef MAP_HUGETLB
+	if(bHuge)
+	{
+		pMem = mmap(NULL, uSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS |
+			MAP_HUGETLB, -1, 0);
+		if(pMem == MAP_FAILED) pMem = NULL;
+		else m_bMappedHuge = true;
+	}
+#endif
+
+	if(pMem == NULL)
+	{
+		pMem = mmap(NULL, uSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(pMem == MAP_FAILED) pMem = NULL;
+#ifdef MADV_HUGEPAGE
+		else if(bHuge) madvise(pMem, uSize, MADV_HUGEPAGE);
+#endif
+	}
+#endif
+
+	if(pMem == NULL) return NULL;
+
+	m_pbBuffer = static_cast<UINT_8*>(pMem);
+	m_uCapacity = uSize;
+	return m_pbBuffer;
+}
+
+void CSHA1BufferArena::Release()
+{
+	if(m_pbBuffer == NULL) return;
+
+#ifdef _WIN32
+	VirtualFree(m_pbBuffer, 0, MEM_RELEASE);
+#else
+	munmap(m_pbBuffer, m_uCapacity);
+#endif
+
+	m_pbBuffer = NULL;
+	m_uCapacity = 0;
+	m_bMappedHuge = false;
+}
+
+CSHA1BufferArena& CSHA1BufferArena::GetThreadArena()
+{
+	static thread_local CSHA1BufferArena s_arena;
+	return s_arena;
+}
@@ -0,0 +1,54 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Reusable page-aligned I/O buffer for the file hashing functions.
+  See SHA1.h for version history.
+
+  An arena holds one buffer that only grows, so hashing many files does
+  not allocate and fault in a new buffer per file. CSHA1::HashFile and the
+  other file-reading utilities use the calling thread's arena by default;
+  a caller-supplied arena can be passed to CSHA1::HashFile instead. With
+  huge pages enabled, buffers of at least 2 MB are backed by huge pages
+  where the system allows it (MAP_HUGETLB or transparent huge pages on
+  Linux, large pages on Windows if the process holds the privilege).
+*/
+
+#ifndef SHA1BUFFERARENA_H_C3D5E7F9A1B24C6E8F0A2B4D6E8F1A3C
+#define SHA1BUFFERARENA_H_C3D5E7F9A1B24C6E8F0A2B4D6E8F1A3C
+
+#include "SHA1.h"
+
+class CSHA1BufferArena
+{
+public:
+	explicit CSHA1BufferArena(bool bHugePages = false);
+	~CSHA1BufferArena();
+
+	// Page-aligned buffer of at least uMinSize bytes, valid until the next
+	// Acquire or Release call; NULL if out of memory
+	UINT_8* Acquire(size_t uMinSize);
+
+	// Free the buffer
+	void Release();
+
+	size_t GetCapacity() const { return m_uCapacity; }
+
+	// Whether the current buffer uses explicit huge or large pages
+	bool IsHugePageBacked() const { return m_bMappedHuge; }
+
+	// Arena of the calling thread (freed when the thread exits)
+	static CSHA1BufferArena& GetThreadArena();
+
+private:
+	CSHA1BufferArena(const CSHA1BufferArena&);
+	CSHA1BufferArena& operator=(const CSHA1BufferArena&);
+
+	UINT_8* m_pbBuffer;
+	size_t m_uCapacity;
+	bool m_bHugePages;
+	bool m_bMappedHuge; // Allocated with explicit huge or large pages
+};
+
+#endif // SHA1BUFFERARENA_H_C3D5E7F9A1B24C6E8F0A2B4D6E8F1A3C
@@ -0,0 +1,274 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1Chunker.h"
+#include "SHA1ThreadPool.h"
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+#include "SHA1MappedFile.h"
+#endif
+
+// Chunks are handed to the worker threads in batches of about this size
+#define SHA1_CHUNKER_BATCH (1024 * 1024)
+
+CSHA1Chunker::CSHA1Chunker(UINT_32 uMinSize, UINT_32 uAvgSize, UINT_32 uMaxSize,
+	size_t uThreads) : m_pPool(NULL)
+{
+	if(uMinSize == 0) uMinSize = 1;
+	if(uAvgSize < uMinSize) uAvgSize = uMinSize;
+	if(uMaxSize < uAvgSize) uMaxSize = uAvgSize;
+
+	m_uMinSize = uMinSize;
+	m_uAvgSize = uAvgSize;
+	m_uMaxSize = uMaxSize;
+
+	// Normalized chunking: 2 bits more before and 2 bits less after the
+	// average size; the masks use the high bits, which depend on the
+	// most input bytes
+	UINT_32 uBits = 0;
+	while((uBits < 31) && ((1UL << (uBits + 1)) <= uAvgSize)) ++uBits;
+	const UINT_32 uBitsS = ((uBits + 2) > 48) ? 48 : (uBits + 2);
+	const UINT_32 uBitsL = (uBits > 2) ? (uBits - 2) : 1;
+	m_uMaskS = ((static_cast<UINT_64>(1) << uBitsS) - 1) << (63 - uBitsS);
+	m_uMaskL = ((static_cast<UINT_64>(1) << uBitsL) - 1) << (63 - uBitsL);
+
+	// Fixed Gear table (SplitMix64), so that boundaries are reproducible
+	UINT_64 uSeed = 0x5348413143444331ULL;
+	for(size_t i = 0; i < 256; ++i)
+	{
+		UINT_64 z = (uSeed += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		m_gear[i] = z ^ (z >> 31);
+		m_gearLs[i] = m_gear[i] << 1;
+	}
+
+	if(uThreads != 1) m_pPool = new CSHA1ThreadPool(uThreads);
+}
+
+CSHA1Chunker::~CSHA1Chunker()
+{
+	delete m_pPool;
+}
+
+size_t CSHA1Chunker::FindBoundary(const UINT_8* pbData, size_t uLen) const
+{
+	if(uLen <= m_uMinSize) return uLen;
+	if(uLen > m_uMaxSize) uLen = m_uMaxSize;
+
+	const size_t uNormal = ((uLen < m_uAvgSize) ? uLen : m_uAvgSize);
+	const UINT_64 uMaskSLs = (m_uMaskS << 1), uMaskLLs = (m_uMaskL << 1);
+	UINT_64 fp = 0;
+	size_t i = m_uMinSize;
+
+	// Two bytes per step: the first byte is added pre-shifted and tested
+	// against the shifted mask, which is equivalent to a single step
+	for( ; (i + 2) <= uNormal; i += 2)
+	{
+		fp = (fp << 2) + m_gearLs[pbData[i]];
+		if((fp & uMaskSLs) == 0) return (i + 1);
+		fp += m_gear[pbData[i + 1]];
+		if((fp & m_uMaskS) == 0) return (i + 2);
+	}
+	if(i < uNormal)
+	{
+		fp = (fp << 1) + m_gear[pbData[i]];
+		if((fp & m_uMaskS) == 0) return (i + 1);
+		++i;
+	}
+
+	for( ; (i + 2) <= uLen; i += 2)
+	{
+		fp = (fp << 2) + m_gearLs[pbData[i]];
+		if((fp & uMaskLLs) == 0) return (i + 1);
+		fp += m_gear[pbData[i + 1]];
+		if((fp & m_uMaskL) == 0) return (i + 2);
+	}
+	if(i < uLen)
+	{
+		fp = (fp << 1) + m_gear[pbData[i]];
+		if((fp & m_uMaskL) == 0) return (i + 1);
+	}
+
+	return uLen;
+}
+
+void CSHA1Chunker::HashBatch(CHUNK_BATCH* pBatch)
+{
+	CSHA1 sha1;
+	for(size_t i = 0; i < pBatch->vChunks.size(); ++i)
+	{
+		SHA1_CHUNK& chunk = pBatch->vChunks[i];
+
+		sha1.Reset();
+		sha1.Update(pBatch->vData[i], chunk.uLength);
+		sha1.Final();
+		sha1.GetHash(chunk.pbHash);
+	}
+}
+
+void CSHA1Chunker::SubmitBatch(CHUNK_BATCH& batch)
+{
+	if(batch.vChunks.empty()) return;
+
+	if(m_pPool == NULL) HashBatch(&batch);
+	else
+	{
+		CHUNK_BATCH* pBatch = &batch;
+		m_pPool->Submit([pBatch]() { HashBatch(pBatch); });
+	}
+}
+
+// At least two maximum chunks, so that every non-final window emits some
+size_t CSHA1Chunker::GetWindowSize() const
+{
+	return ((SHA1_CHUNKER_WINDOW > (2 * static_cast<size_t>(m_uMaxSize))) ?
+		SHA1_CHUNKER_WINDOW : (2 * static_cast<size_t>(m_uMaxSize)));
+}
+
+// Returns the number of bytes consumed. If bFinal is false, only chunks
+// that cannot be affected by data following the region are emitted.
+size_t CSHA1Chunker::ProcessRegion(const UINT_8* pbData, size_t uLen, UINT_64 uBaseOffset,
+	bool bFinal, SHA1_CHUNK_CALLBACK fnCallback, void* pUserData)
+{
+	std::list<CHUNK_BATCH> lBatches; // Elements never move
+	lBatches.push_back(CHUNK_BATCH());
+	size_t uBatchBytes = 0;
+
+	size_t uPos = 0;
+	while(uPos < uLen)
+	{
+		const size_t uRemaining = uLen - uPos;
+		if(!bFinal && (uRemaining < m_uMaxSize)) break;
+
+		const size_t uCut = FindBoundary(&pbData[uPos], uRemaining);
+
+		SHA1_CHUNK chunk;
+		chunk.uOffset = uBaseOffset + uPos;
+		chunk.uLength = static_cast<UINT_32>(uCut);
+
+		CHUNK_BATCH& batch = lBatches.back();
+		batch.vChunks.push_back(chunk);
+		batch.vData.push_back(&pbData[uPos]);
+
+		uBatchBytes += uCut;
+		if(uBatchBytes >= SHA1_CHUNKER_BATCH)
+		{
+			SubmitBatch(batch);
+			lBatches.push_back(CHUNK_BATCH());
+			uBatchBytes = 0;
+		}
+
+		uPos += uCut;
+	}
+
+	SubmitBatch(lBatches.back());
+	if(m_pPool != NULL) m_pPool->Wait();
+
+	for(std::list<CHUNK_BATCH>::const_iterator it = lBatches.begin();
+		it != lBatches.end(); ++it)
+	{
+		for(size_t i = 0; i < it->vChunks.size(); ++i)
+			fnCallback(it->vChunks[i], pUserData);
+	}
+
+	return uPos;
+}
+
+bool CSHA1Chunker::ChunkBuffer(const UINT_8* pbData, size_t uLen,
+	SHA1_CHUNK_CALLBACK fnCallback, void* pUserData)
+{
+	if(((pbData == NULL) && (uLen != 0)) || (fnCallback == NULL)) return false;
+
+	// Bounded windows, so that the chunk records of large (mapped) inputs
+	// are not all held at once and are reported while hashing continues
+	const size_t uWindow = GetWindowSize();
+	size_t uPos = 0;
+	while(true)
+	{
+		const size_t uRegion = (((uLen - uPos) < uWindow) ? (uLen - uPos) : uWindow);
+		const bool bFinal = ((uPos + uRegion) == uLen);
+
+		uPos += ProcessRegion(&pbData[uPos], uRegion, static_cast<UINT_64>(uPos), bFinal,
+			fnCallback, pUserData);
+		if(bFinal) break;
+	}
+
+	return true;
+}
+
+bool CSHA1Chunker::ChunkStream(std::istream& is, SHA1_CHUNK_CALLBACK fnCallback,
+	void* pUserData)
+{
+	if(fnCallback == NULL) return false;
+
+	const size_t uWindow = GetWindowSize();
+	std::vector<UINT_8> vWindow(uWindow);
+	UINT_8* pbWindow = &vWindow[0];
+
+	UINT_64 uBaseOffset = 0;
+	size_t uFill = 0;
+
+	while(true)
+	{
+		is.read(reinterpret_cast<char*>(&pbWindow[uFill]),
+			static_cast<std::streamsize>(uWindow - uFill));
+		uFill += static_cast<size_t>(is.gcount());
+
+		const bool bFinal = !is.good();
+		if(bFinal && !is.eof()) return false;
+
+		const size_t uUsed = ProcessRegion(pbWindow, uFill, uBaseOffset, bFinal,
+			fnCallback, pUserData);
+		if(bFinal) break;
+
+		memmove(pbWindow, &pbWindow[uUsed], uFill - uUsed);
+		uFill -= uUsed;
+		uBaseOffset += uUsed;
+	}
+
+	return true;
+}
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+bool CSHA1Chunker::ChunkFile(const TCHAR* tszFileName, SHA1_CHUNK_CALLBACK fnCallback,
+	void* pUserData)
+{
+	CSHA1MappedFile mf;
+	if(!mf.Open(tszFileName)) return false;
+
+	if(mf.GetSize() > static_cast<UINT_64>(static_cast<size_t>(-1))) return false;
+
+	return ChunkBuffer(mf.GetData(), static_cast<size_t>(mf.GetSize()), fnCallback,
+		pUserData);
+}
+#endif
+
+static void SHA1ChunkToVector(const SHA1_CHUNK& chunk, void* pUserData)
+{
+	static_cast<std::vector<SHA1_CHUNK>*>(pUserData)->push_back(chunk);
+}
+
+bool CSHA1Chunker::ChunkBuffer(const UINT_8* pbData, size_t uLen,
+	std::vector<SHA1_CHUNK>& vChunks)
+{
+	return ChunkBuffer(pbData, uLen, SHA1ChunkToVector, &vChunks);
+}
+
+bool CSHA1Chunker::ChunkStream(std::istream& is, std::vector<SHA1_CHUNK>& vChunks)
+{
+	return ChunkStream(is, SHA1ChunkToVector, &vChunks);
+}
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+bool CSHA1Chunker::ChunkFile(const TCHAR* tszFileName, std::vector<SHA1_CHUNK>& vChunks)
+{
+	return ChunkFile(tszFileName, SHA1ChunkToVector, &vChunks);
+}
+#endif
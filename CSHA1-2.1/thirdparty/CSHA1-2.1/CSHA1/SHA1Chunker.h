@@ -0,0 +1,101 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Content-defined chunking with per-chunk SHA-1 digests, for example for
+  deduplicating backups. See SHA1.h for version history.
+
+  Chunk boundaries are found using a Gear rolling hash with FastCDC
+  normalized chunking (a stricter mask before the average chunk size and
+  a looser one after it). The rolling hash advances two bytes per step.
+  Boundary detection is sequential; the chunks are hashed in parallel on
+  a worker pool while the next boundaries are being searched.
+*/
+
+#ifndef SHA1CHUNKER_H_6506194094A642928A25310E1BEFD87F
+#define SHA1CHUNKER_H_6506194094A642928A25310E1BEFD87F
+
+#include <istream>
+#include <list>
+#include <vector>
+
+#include "SHA1.h"
+
+class CSHA1ThreadPool;
+
+// Size of the read window used by ChunkStream and of the windows in which
+// ChunkBuffer and ChunkFile process their input
+#ifndef SHA1_CHUNKER_WINDOW
+#define SHA1_CHUNKER_WINDOW (16 * 1024 * 1024)
+#endif
+
+typedef struct
+{
+	UINT_64 uOffset;
+	UINT_32 uLength;
+	UINT_8 pbHash[20];
+} SHA1_CHUNK;
+
+// Receives the chunks in stream order
+typedef void (*SHA1_CHUNK_CALLBACK)(const SHA1_CHUNK& chunk, void* pUserData);
+
+class CSHA1Chunker
+{
+public:
+	// Sizes in bytes; uAvgSize should be a power of 2. If uThreads is 0,
+	// one thread per hardware thread is used; 1 hashes in the caller's thread.
+	CSHA1Chunker(UINT_32 uMinSize = 2048, UINT_32 uAvgSize = 8192,
+		UINT_32 uMaxSize = 65536, size_t uThreads = 0);
+	~CSHA1Chunker();
+
+	bool ChunkBuffer(const UINT_8* pbData, size_t uLen, SHA1_CHUNK_CALLBACK fnCallback,
+		void* pUserData);
+	bool ChunkStream(std::istream& is, SHA1_CHUNK_CALLBACK fnCallback, void* pUserData);
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+	// Chunk a memory-mapped file
+	bool ChunkFile(const TCHAR* tszFileName, SHA1_CHUNK_CALLBACK fnCallback,
+		void* pUserData);
+#endif
+
+	// Convenience methods collecting the chunks in a vector
+	bool ChunkBuffer(const UINT_8* pbData, size_t uLen, std::vector<SHA1_CHUNK>& vChunks);
+	bool ChunkStream(std::istream& is, std::vector<SHA1_CHUNK>& vChunks);
+#ifdef SHA1_UTILITY_FUNCTIONS
+	bool ChunkFile(const TCHAR* tszFileName, std::vector<SHA1_CHUNK>& vChunks);
+#endif
+
+	// Length of the chunk starting at pbData (at most uLen bytes)
+	size_t FindBoundary(const UINT_8* pbData, size_t uLen) const;
+
+private:
+	struct CHUNK_BATCH
+	{
+		std::vector<SHA1_CHUNK> vChunks;
+		std::vector<const UINT_8*> vData;
+	};
+
+	size_t GetWindowSize() const;
+	size_t ProcessRegion(const UINT_8* pbData, size_t uLen, UINT_64 uBaseOffset,
+		bool bFinal, SHA1_CHUNK_CALLBACK fnCallback, void* pUserData);
+	void SubmitBatch(CHUNK_BATCH& batch);
+
+	static void HashBatch(CHUNK_BATCH* pBatch);
+
+	CSHA1Chunker(const CSHA1Chunker&);
+	CSHA1Chunker& operator=(const CSHA1Chunker&);
+
+	UINT_32 m_uMinSize;
+	UINT_32 m_uAvgSize;
+	UINT_32 m_uMaxSize;
+	UINT_64 m_uMaskS;
+	UINT_64 m_uMaskL;
+
+	UINT_64 m_gear[256];
+	UINT_64 m_gearLs[256]; // m_gear shifted left by 1
+
+	CSHA1ThreadPool* m_pPool;
+};
+
+#endif // SHA1CHUNKER_H_6506194094A642928A25310E1BEFD87F
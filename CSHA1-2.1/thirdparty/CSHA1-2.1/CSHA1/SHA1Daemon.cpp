@@ -0,0 +1,825 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#include "SHA1Daemon.h"
+
+#ifndef _WIN32
+
+#include "SHA1BufferArena.h"
+#include "SHA1ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// Requests read from one connection before the others are served
+#define SHA1_DAEMON_MAX_READ 64
+
+// Read buffer of path and unsealed descriptor requests
+#define SHA1_DAEMON_READ_BUFFER (1024 * 1024)
+
+// Requests of all connections queued or being hashed; each may hold a
+// received descriptor
+#define SHA1_DAEMON_MAX_JOBS 512
+
+// Connections accepted at once
+#define SHA1_DAEMON_MAX_CONNECTIONS 256
+
+// Socket send buffer of a connection; holds the replies of more than
+// SHA1_DAEMON_MAX_INFLIGHT requests
+#define SHA1_DAEMON_SEND_BUFFER (SHA1_DAEMON_MAX_INFLIGHT * 2048)
+
+struct CSHA1Daemon::DAEMON_CONN
+{
+	int fd;
+	std::mutex mtxSend;
+	std::atomic<size_t> uInFlight;
+
+	explicit DAEMON_CONN(int fdConn) : fd(fdConn), uInFlight(0) { }
+	~DAEMON_CONN() { close(fd); }
+};
+
+struct CSHA1Daemon::DAEMON_JOB
+{
+	std::shared_ptr<DAEMON_CONN> spConn;
+	SHA1_DAEMON_REQUEST req;
+	std::string strPath;
+	int fd;
+};
+
+static bool SHA1DaemonMakeAddress(const char* pszSocketPath, sockaddr_un& addrOut)
+{
+	if(pszSocketPath == NULL) return false;
+
+	const size_t uLen = strlen(pszSocketPath);
+	if((uLen == 0) || (uLen >= sizeof(addrOut.sun_path))) return false;
+
+	memset(&addrOut, 0, sizeof(addrOut));
+	addrOut.sun_family = AF_UNIX;
+	memcpy(addrOut.sun_path, pszSocketPath, uLen);
+	return true;
+}
+
+// Never blocks: a client whose replies do not fit into the send buffer
+// is not reading them and is disconnected
+static void SHA1DaemonSendReply(int fd, std::mutex& mtxSend, UINT_64 uId,
+	UINT_32 uError, UINT_64 uLength, const UINT_8* pbHash20)
+{
+	SHA1_DAEMON_REPLY reply;
+	memset(&reply, 0, sizeof(reply));
+	reply.uMagic = SHA1_DAEMON_MAGIC_REPLY;
+	reply.uError = uError;
+	reply.uId = uId;
+	reply.uLength = uLength;
+	if(pbHash20 != NULL) memcpy(reply.pbHash, pbHash20, 20);
+
+	// A client that has gone away is not an error of the daemon
+	std::lock_guard<std::mutex> lock(mtxSend);
+	ssize_t iSent;
+	do { iSent = send(fd, &reply, sizeof(reply), MSG_DONTWAIT | MSG_NOSIGNAL); }
+	while((iSent < 0) && (errno == EINTR));
+
+	// The poll loop sees the hangup and drops the connection
+	if((iSent < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+		shutdown(fd, SHUT_RDWR);
+}
+
+// Hashes uLength bytes starting at uOffset using pread; 0 or an errno value
+static UINT_32 SHA1DaemonHashRead(int fd, UINT_64 uOffset, UINT_64 uLength, CSHA1& sha1)
+{
+	UINT_8* pbBuffer = CSHA1BufferArena::GetThreadArena().Acquire(SHA1_DAEMON_READ_BUFFER);
+	if(pbBuffer == NULL) return ENOMEM;
+
+	while(uLength != 0)
+	{
+		const size_t uWant = ((uLength < SHA1_DAEMON_READ_BUFFER) ? static_cast<size_t>(uLength) :
+			SHA1_DAEMON_READ_BUFFER);
+		const ssize_t iRead = pread(fd, pbBuffer, uWant, static_cast<off_t>(uOffset));
+		if(iRead < 0)
+		{
+			if(errno == EINTR) continue;
+			return static_cast<UINT_32>(errno);
+		}
+		if(iRead == 0) return EIO; // Truncated meanwhile
+
+		sha1.Update(pbBuffer, static_cast<UINT_32>(iRead));
+		uOffset += static_cast<UINT_64>(iRead);
+		uLength -= static_cast<UINT_64>(iRead);
+	}
+
+	return 0;
+}
+
+// Memfds sealed against shrinking are mapped, everything else is read
+static UINT_32 SHA1DaemonHashFd(int fd, UINT_64 uOffset, UINT_64& uLength,
+	UINT_8* pbHash20Out)
+{
+	struct stat st;
+	if(fstat(fd, &st) != 0) return static_cast<UINT_32>(errno);
+	if(!S_ISREG(st.st_mode)) return EINVAL;
+
+	const UINT_64 uSize = static_cast<UINT_64>(st.st_size);
+	if(uOffset > uSize) return EINVAL;
+	if(uLength == 0) uLength = uSize - uOffset;
+	if(uLength > (uSize - uOffset)) return EINVAL;
+
+	CSHA1 sha1;
+	bool bMapped = false;
+
+#if defined(__linux__) && defined(F_GET_SEALS)
+	// Plain tmpfs/shmem files report F_SEAL_SEAL; only a memfd that still
+	// accepts seals but is not protected against shrinking is refused
+	const int iSeals = fcntl(fd, F_GET_SEALS);
+	if((iSeals >= 0) && ((iSeals & (F_SEAL_SEAL | F_SEAL_SHRINK)) == 0)) return EPERM;
+
+	if((iSeals >= 0) && ((iSeals & F_SEAL_SHRINK) != 0) && (uLength != 0))
+	{
+		const UINT_64 uPage = static_cast<UINT_64>(sysconf(_SC_PAGESIZE));
+		const UINT_64 uMapStart = uOffset - (uOffset % uPage);
+		const size_t uMapLen = static_cast<size_t>(uOffset + uLength - uMapStart);
+
+		void* pMap = mmap(NULL, uMapLen, PROT_READ, MAP_SHARED, fd,
+			static_cast<off_t>(uMapStart));
+		if(pMap != MAP_FAILED)
+		{
+			SHA1_IOVEC v;
+			v.iov_base = static_cast<UINT_8*>(pMap) + (uOffset - uMapStart);
+			v.iov_len = static_cast<size_t>(uLength);
+			sha1.UpdateV(&v, 1);
+
+			munmap(pMap, uMapLen);
+			bMapped = true;
+		}
+	}
+#endif
+
+	if(!bMapped)
+	{
+		const UINT_32 uError = SHA1DaemonHashRead(fd, uOffset, uLength, sha1);
+		if(uError != 0) return uError;
+	}
+
+	sha1.Final();
+	sha1.GetHash(pbHash20Out);
+	return 0;
+}
+
+CSHA1Daemon::CSHA1Daemon(size_t uThreads, size_t uBatchSize) :
+	m_fdListen(-1), m_uBatchSize((uBatchSize != 0) ? uBatchSize : 1), m_uJobs(0)
+{
+	if(pipe(m_pfdWake) != 0) m_pfdWake[0] = m_pfdWake[1] = -1;
+	else
+	{
+		fcntl(m_pfdWake[0], F_SETFD, FD_CLOEXEC);
+		fcntl(m_pfdWake[1], F_SETFD, FD_CLOEXEC);
+		fcntl(m_pfdWake[0], F_SETFL, O_NONBLOCK);
+	}
+
+	// Written by the workers; a full pipe already wakes the poll loop
+	if(pipe(m_pfdResume) != 0) m_pfdResume[0] = m_pfdResume[1] = -1;
+	else
+	{
+		for(size_t i = 0; i < 2; ++i)
+		{
+			fcntl(m_pfdResume[i], F_SETFD, FD_CLOEXEC);
+			fcntl(m_pfdResume[i], F_SETFL, O_NONBLOCK);
+		}
+	}
+
+	m_pPool = new CSHA1ThreadPool(uThreads);
+}
+
+CSHA1Daemon::~CSHA1Daemon()
+{
+	delete m_pPool;
+
+	if(m_fdListen >= 0)
+	{
+		close(m_fdListen);
+		unlink(m_strSocketPath.c_str());
+	}
+
+	if(m_pfdWake[0] >= 0) close(m_pfdWake[0]);
+	if(m_pfdWake[1] >= 0) close(m_pfdWake[1]);
+	if(m_pfdResume[0] >= 0) close(m_pfdResume[0]);
+	if(m_pfdResume[1] >= 0) close(m_pfdResume[1]);
+}
+
+bool CSHA1Daemon::Listen(const char* pszSocketPath, unsigned int uMode)
+{
+	if(m_fdListen >= 0) return false;
+
+	sockaddr_un addr;
+	if(!SHA1DaemonMakeAddress(pszSocketPath, addr)) return false;
+
+	const int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if(fd < 0) return false;
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	unlink(pszSocketPath);
+	if((bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) ||
+		(chmod(pszSocketPath, static_cast<mode_t>(uMode)) != 0) || (listen(fd, SOMAXCONN) != 0))
+	{
+		close(fd);
+		return false;
+	}
+
+	m_fdListen = fd;
+	m_strSocketPath = pszSocketPath;
+	return true;
+}
+
+void CSHA1Daemon::Stop()
+{
+	// Async-signal-safe
+	const char ch = 0;
+	if(m_pfdWake[1] >= 0)
+	{
+		const ssize_t iWritten = write(m_pfdWake[1], &ch, 1);
+		(void)iWritten;
+	}
+}
+
+bool CSHA1Daemon::Run()
+{
+	if((m_fdListen < 0) || (m_pfdWake[0] < 0) || (m_pfdResume[0] < 0)) return false;
+
+	std::vector<std::shared_ptr<DAEMON_CONN> > vConns;
+	std::vector<pollfd> vPoll;
+	std::vector<DAEMON_JOB> vJobs;
+
+	while(true)
+	{
+		// Connections at their limit (or all, if the daemon is at its
+		// limit) are not read until some of their requests are answered
+		const bool bJobsFull = (m_uJobs.load() >= SHA1_DAEMON_MAX_JOBS);
+		vPoll.resize(3 + vConns.size());
+		vPoll[0].fd = m_pfdWake[0];
+		vPoll[1].fd = m_pfdResume[0];
+		vPoll[2].fd = m_fdListen;
+		for(size_t i = 0; i < vPoll.size(); ++i) { vPoll[i].events = POLLIN; vPoll[i].revents = 0; }
+		if(vConns.size() >= SHA1_DAEMON_MAX_CONNECTIONS) vPoll[2].events = 0;
+		for(size_t i = 0; i < vConns.size(); ++i)
+		{
+			vPoll[3 + i].fd = vConns[i]->fd;
+			if(bJobsFull || (vConns[i]->uInFlight.load() >= SHA1_DAEMON_MAX_INFLIGHT))
+				vPoll[3 + i].events = 0;
+		}
+
+		if(poll(&vPoll[0], static_cast<nfds_t>(vPoll.size()), -1) < 0)
+		{
+			if(errno == EINTR) continue;
+			break;
+		}
+
+		if(vPoll[0].revents != 0) break; // Stop
+
+		if(vPoll[1].revents != 0)
+		{
+			char pbDrain[64];
+			while(read(m_pfdResume[0], pbDrain, sizeof(pbDrain)) > 0) { }
+		}
+
+		if((vPoll[2].revents & POLLIN) != 0)
+		{
+			const int fdConn = accept(m_fdListen, NULL, NULL);
+			if(fdConn >= 0)
+			{
+				fcntl(fdConn, F_SETFD, FD_CLOEXEC);
+				const int iSendBuffer = SHA1_DAEMON_SEND_BUFFER;
+				setsockopt(fdConn, SOL_SOCKET, SO_SNDBUF, &iSendBuffer, sizeof(iSendBuffer));
+				vConns.push_back(std::make_shared<DAEMON_CONN>(fdConn));
+			}
+		}
+
+		// Gather all ready requests of this round, then dispatch them together
+		size_t uKept = 0;
+		for(size_t i = 0; i < vConns.size(); ++i)
+		{
+			bool bKeep = true;
+			if(((3 + i) < vPoll.size()) && (vPoll[3 + i].revents != 0))
+			{
+				// A hangup while not reading: the client will not read replies
+				if(vPoll[3 + i].events == 0) bKeep = false;
+				else bKeep = ReadRequests(vConns[i], vJobs);
+			}
+
+			// Closed connections live on until their pending replies are sent
+			if(bKeep) vConns[uKept++] = vConns[i];
+		}
+		vConns.resize(uKept);
+
+		Dispatch(vJobs);
+	}
+
+	char pbDrain[64];
+	while(read(m_pfdWake[0], pbDrain, sizeof(pbDrain)) > 0) { }
+
+	vConns.clear();
+	m_pPool->Wait();
+	return true;
+}
+
+bool CSHA1Daemon::ReadRequests(const std::shared_ptr<DAEMON_CONN>& spConn,
+	std::vector<DAEMON_JOB>& vJobs)
+{
+	UINT_8 pbPacket[SHA1_DAEMON_MAX_PACKET];
+	union
+	{
+		cmsghdr hdr;
+		char pbBuf[CMSG_SPACE(sizeof(int) * 4)];
+	} uControl;
+
+	for(size_t r = 0; r < SHA1_DAEMON_MAX_READ; ++r)
+	{
+		if((spConn->uInFlight.load() >= SHA1_DAEMON_MAX_INFLIGHT) ||
+			(m_uJobs.load() >= SHA1_DAEMON_MAX_JOBS))
+			break; // Read again when requests have been answered
+
+		iovec v;
+		v.iov_base = pbPacket;
+		v.iov_len = sizeof(pbPacket);
+
+		msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &v;
+		msg.msg_iovlen = 1;
+		msg.msg_control = uControl.pbBuf;
+		msg.msg_controllen = sizeof(uControl.pbBuf);
+
+		const ssize_t iRecv = recvmsg(spConn->fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+		if(iRecv < 0)
+		{
+			if(errno == EINTR) continue;
+			return ((errno == EAGAIN) || (errno == EWOULDBLOCK));
+		}
+		if(iRecv == 0) return false; // Peer closed the connection
+
+		// Collect the attached descriptors; only one is used
+		int fdPayload = -1;
+		for(cmsghdr* pCmsg = CMSG_FIRSTHDR(&msg); pCmsg != NULL; pCmsg = CMSG_NXTHDR(&msg, pCmsg))
+		{
+			if((pCmsg->cmsg_level != SOL_SOCKET) || (pCmsg->cmsg_type != SCM_RIGHTS)) continue;
+
+			const size_t uFds = (pCmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			for(size_t k = 0; k < uFds; ++k)
+			{
+				int fd;
+				memcpy(&fd, CMSG_DATA(pCmsg) + (k * sizeof(int)), sizeof(int));
+				if(fdPayload < 0) fdPayload = fd;
+				else close(fd);
+			}
+		}
+
+		DAEMON_JOB job;
+		job.fd = -1;
+		memset(&job.req, 0, sizeof(job.req));
+
+		UINT_32 uError = 0;
+		if((static_cast<size_t>(iRecv) < sizeof(SHA1_DAEMON_REQUEST)) ||
+			((msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0))
+			uError = EMSGSIZE;
+		else
+		{
+			memcpy(&job.req, pbPacket, sizeof(job.req));
+			if(job.req.uMagic != SHA1_DAEMON_MAGIC_REQUEST) uError = EPROTO;
+			else if(job.req.uType == SHA1_DAEMON_REQ_PATH)
+			{
+				job.strPath.assign(reinterpret_cast<const char*>(pbPacket) +
+					sizeof(SHA1_DAEMON_REQUEST), static_cast<size_t>(iRecv) -
+					sizeof(SHA1_DAEMON_REQUEST));
+				if(job.strPath.empty() || (job.strPath.find('\0') != std::string::npos))
+					uError = EINVAL;
+			}
+			else if(job.req.uType == SHA1_DAEMON_REQ_FD)
+			{
+				if(fdPayload < 0) uError = EBADF;
+				else { job.fd = fdPayload; fdPayload = -1; }
+			}
+			else uError = EPROTO;
+		}
+
+		if(fdPayload >= 0) close(fdPayload);
+
+		if(uError != 0)
+		{
+			if(job.fd >= 0) close(job.fd);
+			SHA1DaemonSendReply(spConn->fd, spConn->mtxSend, job.req.uId, uError, 0, NULL);
+			continue;
+		}
+
+		job.spConn = spConn;
+		vJobs.push_back(job);
+		++spConn->uInFlight;
+		++m_uJobs;
+	}
+
+	return true;
+}
+
+void CSHA1Daemon::Dispatch(std::vector<DAEMON_JOB>& vJobs)
+{
+	for(size_t uStart = 0; uStart < vJobs.size(); uStart += m_uBatchSize)
+	{
+		const size_t uEnd = (((uStart + m_uBatchSize) < vJobs.size()) ?
+			(uStart + m_uBatchSize) : vJobs.size());
+
+		std::shared_ptr<std::vector<DAEMON_JOB> > spBatch =
+			std::make_shared<std::vector<DAEMON_JOB> >(vJobs.begin() + uStart,
+			vJobs.begin() + uEnd);
+
+		m_pPool->Submit([this, spBatch]()
+		{
+			UINT_8 pbHash[20];
+
+			for(size_t i = 0; i < spBatch->size(); ++i)
+			{
+				DAEMON_JOB& job = (*spBatch)[i];
+
+				UINT_64 uLength = job.req.uLength;
+				UINT_32 uError;
+				if(job.req.uType == SHA1_DAEMON_REQ_PATH)
+				{
+					uLength = 0;
+					job.fd = open(job.strPath.c_str(), O_RDONLY | O_CLOEXEC);
+					if(job.fd < 0) uError = static_cast<UINT_32>(errno);
+					else uError = SHA1DaemonHashFd(job.fd, 0, uLength, pbHash);
+				}
+				else uError = SHA1DaemonHashFd(job.fd, job.req.uOffset, uLength, pbHash);
+
+				if(job.fd >= 0) close(job.fd);
+
+				SHA1DaemonSendReply(job.spConn->fd, job.spConn->mtxSend, job.req.uId, uError,
+					((uError == 0) ? uLength : 0), ((uError == 0) ? pbHash : NULL));
+
+				// Let the poll loop read from a connection that was at its limit
+				const bool bConnFull = (job.spConn->uInFlight-- == SHA1_DAEMON_MAX_INFLIGHT);
+				const bool bJobsFull = (m_uJobs-- == SHA1_DAEMON_MAX_JOBS);
+				if((bConnFull || bJobsFull) && (m_pfdResume[1] >= 0))
+				{
+					const char ch = 0;
+					const ssize_t iWritten = write(m_pfdResume[1], &ch, 1);
+					(void)iWritten;
+				}
+				job.spConn.reset();
+			}
+		});
+	}
+
+	vJobs.clear();
+}
+
+CSHA1DaemonClient::CSHA1DaemonClient() :
+	m_fd(-1), m_uNextId(1)
+{
+}
+
+CSHA1DaemonClient::~CSHA1DaemonClient()
+{
+	Close();
+}
+
+bool CSHA1DaemonClient::Connect(const char* pszSocketPath)
+{
+	Close();
+
+	sockaddr_un addr;
+	if(!SHA1DaemonMakeAddress(pszSocketPath, addr)) return false;
+
+	const int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if(fd < 0) return false;
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	if(connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	m_fd = fd;
+	return true;
+}
+
+void CSHA1DaemonClient::Close()
+{
+	if(m_fd >= 0) close(m_fd);
+	m_fd = -1;
+	m_mapEarly.clear();
+}
+
+bool CSHA1DaemonClient::SubmitFile(const char* pszFileName, UINT_64 uId)
+{
+	if((m_fd < 0) || (pszFileName == NULL)) return false;
+
+	const size_t uPathLen = strlen(pszFileName);
+	if((uPathLen == 0) || ((sizeof(SHA1_DAEMON_REQUEST) + uPathLen) > SHA1_DAEMON_MAX_PACKET))
+		return false;
+
+	UINT_8 pbPacket[SHA1_DAEMON_MAX_PACKET];
+	SHA1_DAEMON_REQUEST req;
+	memset(&req, 0, sizeof(req));
+	req.uMagic = SHA1_DAEMON_MAGIC_REQUEST;
+	req.uType = SHA1_DAEMON_REQ_PATH;
+	req.uId = uId;
+	memcpy(pbPacket, &req, sizeof(req));
+	memcpy(pbPacket + sizeof(req), pszFileName, uPathLen);
+
+	const size_t uLen = sizeof(req) + uPathLen;
+	return (send(m_fd, pbPacket, uLen, MSG_NOSIGNAL) == static_cast<ssize_t>(uLen));
+}
+
+bool CSHA1DaemonClient::SubmitFd(int fd, UINT_64 uOffset, UINT_64 uLength, UINT_64 uId)
+{
+	if((m_fd < 0) || (fd < 0)) return false;
+
+	SHA1_DAEMON_REQUEST req;
+	memset(&req, 0, sizeof(req));
+	req.uMagic = SHA1_DAEMON_MAGIC_REQUEST;
+	req.uType = SHA1_DAEMON_REQ_FD;
+	req.uId = uId;
+	req.uOffset = uOffset;
+	req.uLength = uLength;
+
+	iovec v;
+	v.iov_base = &req;
+	v.iov_len = sizeof(req);
+
+	union
+	{
+		cmsghdr hdr;
+		char pbBuf[CMSG_SPACE(sizeof(int))];
+	} uControl;
+	memset(&uControl, 0, sizeof(uControl));
+
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &v;
+	msg.msg_iovlen = 1;
+	msg.msg_control = uControl.pbBuf;
+	msg.msg_controllen = sizeof(uControl.pbBuf);
+
+	cmsghdr* pCmsg = CMSG_FIRSTHDR(&msg);
+	pCmsg->cmsg_level = SOL_SOCKET;
+	pCmsg->cmsg_type = SCM_RIGHTS;
+	pCmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(pCmsg), &fd, sizeof(int));
+
+	return (sendmsg(m_fd, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(req)));
+}
+
+bool CSHA1DaemonClient::Receive(SHA1_DAEMON_REPLY& replyOut)
+{
+	if(m_fd < 0) return false;
+
+	if(!m_mapEarly.empty())
+	{
+		replyOut = m_mapEarly.begin()->second;
+		m_mapEarly.erase(m_mapEarly.begin());
+		return true;
+	}
+
+	while(true)
+	{
+		const ssize_t iRecv = recv(m_fd, &replyOut, sizeof(replyOut), 0);
+		if((iRecv < 0) && (errno == EINTR)) continue;
+
+		return ((iRecv == static_cast<ssize_t>(sizeof(replyOut))) &&
+			(replyOut.uMagic == SHA1_DAEMON_MAGIC_REPLY));
+	}
+}
+
+bool CSHA1DaemonClient::WaitReply(UINT_64 uId, UINT_8* pbHash20Out)
+{
+	SHA1_DAEMON_REPLY reply;
+
+	std::map<UINT_64, SHA1_DAEMON_REPLY>::iterator it = m_mapEarly.find(uId);
+	if(it != m_mapEarly.end())
+	{
+		reply = it->second;
+		m_mapEarly.erase(it);
+	}
+	else
+	{
+		while(true)
+		{
+			const ssize_t iRecv = recv(m_fd, &reply, sizeof(reply), 0);
+			if((iRecv < 0) && (errno == EINTR)) continue;
+			if((iRecv != static_cast<ssize_t>(sizeof(reply))) ||
+				(reply.uMagic != SHA1_DAEMON_MAGIC_REPLY))
+				return false;
+
+			if(reply.uId == uId) break;
+			m_mapEarly[reply.uId] = reply;
+		}
+	}
+
+	if(reply.uError != 0)
+	{
+		errno = static_cast<int>(reply.uError);
+		return false;
+	}
+
+	if(pbHash20Out != NULL) memcpy(pbHash20Out, reply.pbHash, 20);
+	return true;
+}
+
+bool CSHA1DaemonClient::HashFile(const char* pszFileName, UINT_8* pbHash20Out)
+{
+	const UINT_64 uId = m_uNextId++;
+	if(!SubmitFile(pszFileName, uId)) return false;
+	return WaitReply(uId, pbHash20Out);
+}
+
+bool CSHA1DaemonClient::HashFd(int fd, UINT_64 uOffset, UINT_64 uLength,
+	UINT_8* pbHash20Out)
+{
+	const UINT_64 uId = m_uNextId++;
+	if(!SubmitFd(fd, uOffset, uLength, uId)) return false;
+	return WaitReply(uId, pbHash20Out);
+}
+
+bool CSHA1DaemonClient::HashBuffer(const void* pData, size_t uLen, UINT_8* pbHash20Out)
+{
+	if(uLen == 0)
+	{
+		CSHA1 sha1;
+		sha1.Final();
+		return sha1.GetHash(pbHash20Out);
+	}
+
+	const int fd = CreatePayloadFd(pData, uLen);
+	if(fd < 0) return false;
+
+	const bool bResult = HashFd(fd, 0, uLen, pbHash20Out);
+	close(fd);
+	return bResult;
+}
+
+int CSHA1DaemonClient::CreatePayloadFd(const void* pData, size_t uLen)
+{
+	if((pData == NULL) && (uLen != 0)) return -1;
+
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+	const int fd = memfd_create("csha1-payload", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+	char pszTemp[] = "/tmp/csha1-payload-XXXXXX";
+	const int fd = mkstemp(pszTemp);
+	if(fd >= 0)
+	{
+		unlink(pszTemp);
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+	}
+#endif
+	if(fd < 0) return -1;
+
+	const UINT_8* pb = static_cast<const UINT_8*>(pData);
+	size_t uWritten = 0;
+	while(uWritten < uLen)
+	{
+		const ssize_t iWritten = write(fd, pb + uWritten, uLen - uWritten);
+		if(iWritten < 0)
+		{
+			if(errno == EINTR) continue;
+			close(fd);
+			return -1;
+		}
+		uWritten += static_cast<size_t>(iWritten);
+	}
+
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+	if(fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+#endif
+
+	return fd;
+}
+
+bool SHA1DaemonLoadTest(const char* pszSocketPath, size_t uConnections,
+	UINT_64 uRequests, size_t uPayloadSize, size_t uWindow,
+	SHA1_DAEMON_LOAD_RESULT& resultOut)
+{
+	memset(&resultOut, 0, sizeof(resultOut));
+	if((uConnections == 0) || (uWindow == 0)) return false;
+
+	std::vector<UINT_8> vPayload(uPayloadSize + 1);
+	for(size_t i = 0; i < vPayload.size(); ++i)
+		vPayload[i] = static_cast<UINT_8>((i * 31) ^ (i >> 8));
+
+	const int fdPayload = CSHA1DaemonClient::CreatePayloadFd(&vPayload[0], uPayloadSize);
+	if(fdPayload < 0) return false;
+
+	std::atomic<UINT_64> uAnswered(0), uErrors(0);
+	std::atomic<bool> bConnectFailed(false);
+
+	const std::chrono::steady_clock::time_point tpStart = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> vThreads;
+	for(size_t c = 0; c < uConnections; ++c)
+	{
+		vThreads.push_back(std::thread([&]()
+		{
+			CSHA1DaemonClient client;
+			if(!client.Connect(pszSocketPath)) { bConnectFailed = true; return; }
+
+			UINT_64 uSent = 0, uDone = 0;
+			while(uDone < uRequests)
+			{
+				while((uSent < uRequests) && ((uSent - uDone) < uWindow))
+				{
+					if(!client.SubmitFd(fdPayload, 0, uPayloadSize, uSent)) break;
+					++uSent;
+				}
+				if(uSent == uDone) { uErrors += (uRequests - uDone); break; }
+
+				SHA1_DAEMON_REPLY reply;
+				if(!client.Receive(reply)) { uErrors += (uRequests - uDone); break; }
+
+				if(reply.uError != 0) ++uErrors;
+				++uDone;
+				++uAnswered;
+			}
+		}));
+	}
+
+	for(size_t c = 0; c < vThreads.size(); ++c) vThreads[c].join();
+	close(fdPayload);
+
+	resultOut.dSeconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - tpStart).count();
+	resultOut.uRequests = uAnswered;
+	resultOut.uErrors = uErrors;
+	resultOut.uBytes = ((resultOut.uRequests > resultOut.uErrors) ? (resultOut.uRequests -
+		resultOut.uErrors) : 0) * static_cast<UINT_64>(uPayloadSize);
+	if(resultOut.dSeconds > 0.0)
+	{
+		resultOut.dRequestsPerSecond = static_cast<double>(resultOut.uRequests) / resultOut.dSeconds;
+		resultOut.dMegabytesPerSecond = (static_cast<double>(resultOut.uBytes) /
+			(1024.0 * 1024.0)) / resultOut.dSeconds;
+	}
+
+	return !bConnectFailed;
+}
+
+bool SHA1DaemonSelfTest(const char* pszSocketPath, const char* pszTempDir)
+{
+	std::vector<UINT_8> vData(3 * SHA1_DAEMON_READ_BUFFER + 123);
+	for(size_t i = 0; i < vData.size(); ++i)
+		vData[i] = static_cast<UINT_8>((i * 131) ^ (i >> 11));
+
+	UINT_8 pbExpected[20], pbPart[20], pbHash[20];
+	CSHA1 sha1;
+	sha1.Update(&vData[0], static_cast<UINT_32>(vData.size()));
+	sha1.Final();
+	sha1.GetHash(pbExpected);
+	sha1.Reset();
+	sha1.Update(&vData[1000], 5000);
+	sha1.Final();
+	sha1.GetHash(pbPart);
+
+	CSHA1DaemonClient client;
+	if(!client.Connect(pszSocketPath)) return false;
+
+	if(!client.HashBuffer(&vData[0], vData.size(), pbHash)) return false;
+	if(memcmp(pbHash, pbExpected, 20) != 0) return false;
+
+	std::string strPath = ((pszTempDir != NULL) ? pszTempDir : "/dev/shm");
+	strPath += "/sha1dXXXXXX";
+	std::vector<char> vPath(strPath.begin(), strPath.end());
+	vPath.push_back(0);
+
+	const int fd = mkstemp(&vPath[0]);
+	if(fd < 0) return false;
+
+	bool bSuccess = (write(fd, &vData[0], vData.size()) ==
+		static_cast<ssize_t>(vData.size()));
+	bSuccess = bSuccess && client.HashFile(&vPath[0], pbHash) &&
+		(memcmp(pbHash, pbExpected, 20) == 0);
+	bSuccess = bSuccess && client.HashFd(fd, 0, 0, pbHash) &&
+		(memcmp(pbHash, pbExpected, 20) == 0);
+	bSuccess = bSuccess && client.HashFd(fd, 1000, 5000, pbHash) &&
+		(memcmp(pbHash, pbPart, 20) == 0);
+
+	unlink(&vPath[0]);
+	close(fd);
+	return bSuccess;
+}
+
+#endif // !_WIN32
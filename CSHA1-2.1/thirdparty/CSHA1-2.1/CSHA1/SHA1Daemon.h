@@ -0,0 +1,171 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Local hashing daemon and client library (POSIX only). See SHA1.h for
+  version history.
+
+  Processes on a host send hashing requests to one daemon over a Unix
+  domain socket (SOCK_SEQPACKET, one request or reply per packet) instead
+  of each running their own thread pool. A request names either a file
+  path or a file descriptor passed along with it (SCM_RIGHTS), for example
+  a memfd holding the payload, so the data itself is never copied through
+  the socket. The daemon collects all requests that are ready in one poll
+  round into batches for its worker pool and replies with the digests;
+  replies may arrive in a different order than the requests.
+
+  Path requests are read with the daemon's permissions, so the socket is
+  created with mode 0600 by default. Descriptors of memfds that still
+  accept seals must be sealed against shrinking (CSHA1DaemonClient does
+  this), since a truncation while the daemon maps the data would crash
+  it. Only such memfds are mapped; other files (including plain tmpfs
+  files) are read.
+*/
+
+#ifndef SHA1DAEMON_H_5C0D8A3E1B7F4A29B6E2D4F8A1C3E5B7
+#define SHA1DAEMON_H_5C0D8A3E1B7F4A29B6E2D4F8A1C3E5B7
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "SHA1.h"
+
+class CSHA1ThreadPool;
+
+#define SHA1_DAEMON_MAGIC_REQUEST 0x51523153 // "S1RQ"
+#define SHA1_DAEMON_MAGIC_REPLY 0x50523153 // "S1RP"
+
+#define SHA1_DAEMON_REQ_PATH 1 // Path follows the header
+#define SHA1_DAEMON_REQ_FD 2 // Descriptor attached to the packet
+
+// Maximum packet size (header and path)
+#define SHA1_DAEMON_MAX_PACKET 4160
+
+// Requests of one connection queued or being hashed; further requests are
+// not read until some have been answered. Replies are sent without
+// blocking, so a client must read them: one that lets more than about this
+// many replies pile up is disconnected.
+#ifndef SHA1_DAEMON_MAX_INFLIGHT
+#define SHA1_DAEMON_MAX_INFLIGHT 64
+#endif
+
+typedef struct
+{
+	UINT_32 uMagic;
+	UINT_32 uType;
+	UINT_64 uId; // Chosen by the client, copied to the reply
+	UINT_64 uOffset; // SHA1_DAEMON_REQ_FD only
+	UINT_64 uLength; // SHA1_DAEMON_REQ_FD only; 0 means up to the end
+} SHA1_DAEMON_REQUEST;
+
+typedef struct
+{
+	UINT_32 uMagic;
+	UINT_32 uError; // 0 or an errno value
+	UINT_64 uId;
+	UINT_64 uLength; // Number of bytes hashed
+	UINT_8 pbHash[20];
+	UINT_8 pbReserved[4];
+} SHA1_DAEMON_REPLY;
+
+class CSHA1Daemon
+{
+public:
+	// If uThreads is 0, one thread per hardware thread is used
+	explicit CSHA1Daemon(size_t uThreads = 0, size_t uBatchSize = 8);
+	~CSHA1Daemon();
+
+	// Create the listening socket; an existing socket file is replaced
+	bool Listen(const char* pszSocketPath, unsigned int uMode = 0600);
+
+	// Serve requests until Stop is called (from any thread or a signal handler)
+	bool Run();
+	void Stop();
+
+private:
+	struct DAEMON_CONN;
+	struct DAEMON_JOB;
+
+	bool ReadRequests(const std::shared_ptr<DAEMON_CONN>& spConn,
+		std::vector<DAEMON_JOB>& vJobs);
+	void Dispatch(std::vector<DAEMON_JOB>& vJobs);
+
+	CSHA1Daemon(const CSHA1Daemon&);
+	CSHA1Daemon& operator=(const CSHA1Daemon&);
+
+	int m_fdListen;
+	int m_pfdWake[2];
+	int m_pfdResume[2]; // Signals that a connection may be read again
+	size_t m_uBatchSize;
+	std::atomic<size_t> m_uJobs;
+	std::string m_strSocketPath;
+
+	CSHA1ThreadPool* m_pPool;
+};
+
+class CSHA1DaemonClient
+{
+public:
+	CSHA1DaemonClient();
+	~CSHA1DaemonClient();
+
+	bool Connect(const char* pszSocketPath);
+	void Close();
+
+	// Asynchronous requests; the replies are collected using Receive
+	bool SubmitFile(const char* pszFileName, UINT_64 uId);
+	bool SubmitFd(int fd, UINT_64 uOffset, UINT_64 uLength, UINT_64 uId);
+	bool Receive(SHA1_DAEMON_REPLY& replyOut);
+
+	// Synchronous requests; pbHash20Out receives the digest. HashBuffer
+	// copies the data into a sealed memfd (or an unlinked temporary file).
+	bool HashFile(const char* pszFileName, UINT_8* pbHash20Out);
+	bool HashFd(int fd, UINT_64 uOffset, UINT_64 uLength, UINT_8* pbHash20Out);
+	bool HashBuffer(const void* pData, size_t uLen, UINT_8* pbHash20Out);
+
+	// Create a descriptor holding a copy of the data, usable with SubmitFd
+	static int CreatePayloadFd(const void* pData, size_t uLen);
+
+private:
+	bool WaitReply(UINT_64 uId, UINT_8* pbHash20Out);
+
+	CSHA1DaemonClient(const CSHA1DaemonClient&);
+	CSHA1DaemonClient& operator=(const CSHA1DaemonClient&);
+
+	int m_fd;
+	UINT_64 m_uNextId;
+	std::map<UINT_64, SHA1_DAEMON_REPLY> m_mapEarly; // Replies to other requests
+};
+
+typedef struct
+{
+	UINT_64 uRequests;
+	UINT_64 uErrors;
+	UINT_64 uBytes;
+	double dSeconds;
+	double dRequestsPerSecond;
+	double dMegabytesPerSecond;
+} SHA1_DAEMON_LOAD_RESULT;
+
+// Load generator: uConnections clients each keep up to uWindow requests
+// of uPayloadSize bytes (one shared memfd) in flight until uRequests
+// requests have been answered per connection.
+bool SHA1DaemonLoadTest(const char* pszSocketPath, size_t uConnections,
+	UINT_64 uRequests, size_t uPayloadSize, size_t uWindow,
+	SHA1_DAEMON_LOAD_RESULT& resultOut);
+
+// Checks the daemon's digests of a buffer and of a regular file created
+// in pszTempDir (default /dev/shm, i.e. on tmpfs) requested by path and
+// by descriptor against locally computed ones.
+bool SHA1DaemonSelfTest(const char* pszSocketPath, const char* pszTempDir = NULL);
+
+#endif // !_WIN32
+
+#endif // SHA1DAEMON_H_5C0D8A3E1B7F4A29B6E2D4F8A1C3E5B7
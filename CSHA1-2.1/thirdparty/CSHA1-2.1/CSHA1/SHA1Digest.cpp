@@ -0,0 +1,142 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#include "SHA1Digest.h"
+#include "SHA1ThreadPool.h"
+
+#include <algorithm>
+
+// Buckets smaller than this are sorted using a comparison sort
+#define SHA1_RADIX_MIN_BUCKET 64
+
+// Arrays smaller than this are sorted in the calling thread
+#define SHA1_RADIX_MIN_PARALLEL (1 << 16)
+
+static void SHA1RadixCount(const CSHA1Digest* pDigests, size_t uCount, size_t uByte,
+	size_t* pCounts)
+{
+	for(size_t i = 0; i < uCount; ++i) ++pCounts[pDigests[i].m_pbHash[uByte]];
+}
+
+// Moves the digests into their buckets; pCounts are the bucket sizes
+static void SHA1RadixPermute(CSHA1Digest* pDigests, size_t uByte, const size_t* pCounts,
+	size_t* pBucketStart)
+{
+	size_t pNext[256];
+	size_t uPos = 0;
+	for(size_t k = 0; k < 256; ++k)
+	{
+		pBucketStart[k] = uPos;
+		pNext[k] = uPos;
+		uPos += pCounts[k];
+	}
+	pBucketStart[256] = uPos;
+
+	for(size_t k = 0; k < 256; ++k)
+	{
+		while(pNext[k] < pBucketStart[k + 1])
+		{
+			const UINT_8 d = pDigests[pNext[k]].m_pbHash[uByte];
+			if(d == k) ++pNext[k];
+			else
+			{
+				std::swap(pDigests[pNext[k]], pDigests[pNext[d]]);
+				++pNext[d];
+			}
+		}
+	}
+}
+
+static void SHA1RadixSort(CSHA1Digest* pDigests, size_t uCount, size_t uByte)
+{
+	if((uCount < SHA1_RADIX_MIN_BUCKET) || (uByte >= 20))
+	{
+		std::sort(pDigests, pDigests + uCount);
+		return;
+	}
+
+	size_t pCounts[256] = { 0 };
+	SHA1RadixCount(pDigests, uCount, uByte, pCounts);
+
+	size_t pBucketStart[257];
+	SHA1RadixPermute(pDigests, uByte, pCounts, pBucketStart);
+
+	for(size_t k = 0; k < 256; ++k)
+	{
+		if(pCounts[k] > 1)
+			SHA1RadixSort(&pDigests[pBucketStart[k]], pCounts[k], uByte + 1);
+	}
+}
+
+void SHA1SortDigests(CSHA1Digest* pDigests, size_t uCount, size_t uThreads)
+{
+	if((pDigests == NULL) || (uCount < 2)) return;
+
+	if((uCount < SHA1_RADIX_MIN_PARALLEL) || (uThreads == 1))
+	{
+		SHA1RadixSort(pDigests, uCount, 0);
+		return;
+	}
+
+	CSHA1ThreadPool pool(uThreads);
+	const size_t uParts = pool.GetThreadCount();
+
+	// Count the first byte in parallel
+	std::vector<size_t> vCounts(uParts * 256, 0);
+	const size_t uPartSize = (uCount + uParts - 1) / uParts;
+	for(size_t p = 0; p < uParts; ++p)
+	{
+		const size_t uStart = p * uPartSize;
+		if(uStart >= uCount) break;
+		const size_t uLen = (((uStart + uPartSize) < uCount) ? uPartSize : (uCount - uStart));
+
+		size_t* pCounts = &vCounts[p * 256];
+		pool.Submit([pDigests, uStart, uLen, pCounts]()
+			{ SHA1RadixCount(&pDigests[uStart], uLen, 0, pCounts); });
+	}
+	pool.Wait();
+
+	size_t pCounts[256] = { 0 };
+	for(size_t p = 0; p < uParts; ++p)
+	{
+		for(size_t k = 0; k < 256; ++k) pCounts[k] += vCounts[(p * 256) + k];
+	}
+
+	size_t pBucketStart[257];
+	SHA1RadixPermute(pDigests, 0, pCounts, pBucketStart);
+
+	// The buckets are independent
+	for(size_t k = 0; k < 256; ++k)
+	{
+		if(pCounts[k] < 2) continue;
+
+		CSHA1Digest* pBucket = &pDigests[pBucketStart[k]];
+		const size_t uBucket = pCounts[k];
+		pool.Submit([pBucket, uBucket]() { SHA1RadixSort(pBucket, uBucket, 1); });
+	}
+	pool.Wait();
+}
+
+void SHA1SortDigests(std::vector<CSHA1Digest>& vDigests, size_t uThreads)
+{
+	if(vDigests.empty()) return;
+	SHA1SortDigests(&vDigests[0], vDigests.size(), uThreads);
+}
+
+size_t SHA1UniqueDigests(std::vector<CSHA1Digest>& vDigests)
+{
+	const size_t uOrgSize = vDigests.size();
+	vDigests.erase(std::unique(vDigests.begin(), vDigests.end()), vDigests.end());
+	return (uOrgSize - vDigests.size());
+}
+
+size_t SHA1SortUniqueDigests(std::vector<CSHA1Digest>& vDigests, size_t uThreads)
+{
+	SHA1SortDigests(vDigests, uThreads);
+	return SHA1UniqueDigests(vDigests);
+}
@@ -0,0 +1,125 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  CSHA1Digest value type and sorting of large digest arrays.
+  See SHA1.h for version history.
+
+  CSHA1Digest is a trivially copyable 20-byte value that is ordered like
+  memcmp, hashable using std::hash and can be parsed from hex at compile
+  time (C++14 or later):
+
+    constexpr CSHA1Digest d = CSHA1Digest::FromHex(
+        "a9993e364706816aba3e25717850c26c9cd0d89d");
+*/
+
+#ifndef SHA1DIGEST_H_A4E863C242DF4B38A7AC7847E84B27FF
+#define SHA1DIGEST_H_A4E863C242DF4B38A7AC7847E84B27FF
+
+#include <functional>
+#include <vector>
+
+#include "SHA1.h"
+
+#if (__cplusplus >= 201402L) || (defined(_MSVC_LANG) && (_MSVC_LANG >= 201402L))
+#define SHA1_CONSTEXPR14 constexpr
+#else
+#define SHA1_CONSTEXPR14
+#endif
+
+// Not constexpr on purpose: reaching it during constant evaluation (an
+// invalid hex string) makes the evaluation fail at compile time
+inline UINT_8 SHA1InvalidHexDigit() { return 0xFF; }
+
+class CSHA1Digest
+{
+public:
+	UINT_8 m_pbHash[20];
+
+	// Zero digest
+	SHA1_CONSTEXPR14 CSHA1Digest() : m_pbHash() { }
+
+	explicit CSHA1Digest(const UINT_8* pbHash20) { memcpy(m_pbHash, pbHash20, 20); }
+
+	// Digest of a finalized CSHA1 object
+	explicit CSHA1Digest(const CSHA1& sha1) { sha1.GetHash(m_pbHash); }
+
+	// Parses 40 hex digits (both cases); returns false for invalid input
+	static SHA1_CONSTEXPR14 bool TryParseHex(const char* pszHex, CSHA1Digest& dOut)
+	{
+		if(pszHex == NULL) return false;
+
+		for(size_t i = 0; i < 20; ++i)
+		{
+			const UINT_8 h = HexValue(pszHex[i << 1]);
+			if(h == 0xFF) return false;
+			const UINT_8 l = HexValue(pszHex[(i << 1) + 1]);
+			if(l == 0xFF) return false;
+
+			dOut.m_pbHash[i] = static_cast<UINT_8>((h << 4) | l);
+		}
+
+		return (pszHex[40] == 0);
+	}
+
+	// Invalid input is a compile-time error in constant expressions and
+	// results in the zero digest otherwise
+	static SHA1_CONSTEXPR14 CSHA1Digest FromHex(const char* pszHex)
+	{
+		CSHA1Digest d;
+		if(!TryParseHex(pszHex, d))
+		{
+			SHA1InvalidHexDigit();
+			return CSHA1Digest();
+		}
+
+		return d;
+	}
+
+	int Compare(const CSHA1Digest& d) const { return memcmp(m_pbHash, d.m_pbHash, 20); }
+
+	bool operator==(const CSHA1Digest& d) const { return (Compare(d) == 0); }
+	bool operator!=(const CSHA1Digest& d) const { return (Compare(d) != 0); }
+	bool operator<(const CSHA1Digest& d) const { return (Compare(d) < 0); }
+	bool operator>(const CSHA1Digest& d) const { return (Compare(d) > 0); }
+	bool operator<=(const CSHA1Digest& d) const { return (Compare(d) <= 0); }
+	bool operator>=(const CSHA1Digest& d) const { return (Compare(d) >= 0); }
+
+private:
+	static SHA1_CONSTEXPR14 UINT_8 HexValue(char ch)
+	{
+		if((ch >= '0') && (ch <= '9')) return static_cast<UINT_8>(ch - '0');
+		if((ch >= 'a') && (ch <= 'f')) return static_cast<UINT_8>(ch - 'a' + 10);
+		if((ch >= 'A') && (ch <= 'F')) return static_cast<UINT_8>(ch - 'A' + 10);
+		return 0xFF;
+	}
+};
+
+namespace std
+{
+	// Digests are uniformly distributed, so the first bytes are a good hash
+	template<> struct hash<CSHA1Digest>
+	{
+		size_t operator()(const CSHA1Digest& d) const
+		{
+			size_t h;
+			memcpy(&h, d.m_pbHash, sizeof(h));
+			return h;
+		}
+	};
+}
+
+// In-place MSD radix sort (American flag sort). The first level is
+// counted in parallel, the 256 resulting buckets are sorted in parallel.
+// If uThreads is 0, one thread per hardware thread is used.
+void SHA1SortDigests(CSHA1Digest* pDigests, size_t uCount, size_t uThreads = 0);
+void SHA1SortDigests(std::vector<CSHA1Digest>& vDigests, size_t uThreads = 0);
+
+// Removes duplicates from a sorted vector; returns the number removed
+size_t SHA1UniqueDigests(std::vector<CSHA1Digest>& vDigests);
+
+// Sorts and removes duplicates; returns the number of duplicates removed
+size_t SHA1SortUniqueDigests(std::vector<CSHA1Digest>& vDigests, size_t uThreads = 0);
+
+#endif // SHA1DIGEST_H_A4E863C242DF4B38A7AC7847E84B27FF
@@ -0,0 +1,258 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#include "SHA1DigestSet.h"
+
+#include <new>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SHA1_DIGESTSET_SSE2
+#include <emmintrin.h>
+#endif
+
+// Slot states; SHA1_SLOT_MOVED is set on slots of a superseded table
+// when they have been migrated (frozen)
+#define SHA1_SLOT_EMPTY 0
+#define SHA1_SLOT_BUSY 1
+#define SHA1_SLOT_FULL 2
+#define SHA1_SLOT_MOVED 4
+
+#define SHA1_DIGESTSET_MIN_CAPACITY 64
+#define SHA1_DIGESTSET_MIGRATE_CHUNK 1024
+
+static inline bool SHA1DigestEqual(const UINT_8* pbA, const UINT_8* pbB)
+{
+#ifdef SHA1_DIGESTSET_SSE2
+	const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pbA));
+	const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pbB));
+	if(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) return false;
+
+	UINT_32 uTailA, uTailB;
+	memcpy(&uTailA, &pbA[16], 4);
+	memcpy(&uTailB, &pbB[16], 4);
+	return (uTailA == uTailB);
+#else
+	return (memcmp(pbA, pbB, 20) == 0);
+#endif
+}
+
+// The digest is uniformly distributed, so its first bytes are the hash
+static inline size_t SHA1DigestSlot(const UINT_8* pbHash20, size_t uMask)
+{
+	UINT_64 u;
+	memcpy(&u, pbHash20, 8);
+	return (static_cast<size_t>(u) & uMask);
+}
+
+CSHA1DigestSet::CSHA1DigestSet(size_t uInitialCapacity) :
+	m_uSize(0)
+{
+	// Keep the load factor at most 1/2
+	m_pFirst = CreateTable(uInitialCapacity * 2);
+	m_pRoot.store(m_pFirst);
+}
+
+CSHA1DigestSet::~CSHA1DigestSet()
+{
+	DIGEST_TABLE* pTable = m_pFirst;
+	while(pTable != NULL)
+	{
+		DIGEST_TABLE* pNext = pTable->pNext.load();
+		DestroyTable(pTable);
+		pTable = pNext;
+	}
+}
+
+CSHA1DigestSet::DIGEST_TABLE* CSHA1DigestSet::CreateTable(size_t uCapacity)
+{
+	size_t uSize = SHA1_DIGESTSET_MIN_CAPACITY;
+	while(uSize < uCapacity) uSize <<= 1;
+
+	DIGEST_TABLE* pTable = new DIGEST_TABLE();
+	pTable->uMask = uSize - 1;
+	pTable->uCount.store(0);
+	pTable->pNext.store(NULL);
+	pTable->uMigrateNext.store(0);
+	pTable->uMigrated.store(0);
+
+	// Slots are aligned to cache lines
+	pTable->pMemory = ::operator new((uSize * sizeof(DIGEST_SLOT)) + 64);
+	const size_t uAddr = reinterpret_cast<size_t>(pTable->pMemory);
+	pTable->pSlots = reinterpret_cast<DIGEST_SLOT*>((uAddr + 63) & ~static_cast<size_t>(63));
+
+	for(size_t i = 0; i < uSize; ++i)
+	{
+		DIGEST_SLOT* pSlot = new(&pTable->pSlots[i]) DIGEST_SLOT;
+		pSlot->uState.store(SHA1_SLOT_EMPTY, std::memory_order_relaxed);
+	}
+
+	return pTable;
+}
+
+void CSHA1DigestSet::DestroyTable(DIGEST_TABLE* pTable)
+{
+	::operator delete(pTable->pMemory);
+	delete pTable;
+}
+
+void CSHA1DigestSet::StartGrowth(DIGEST_TABLE* pTable)
+{
+	if(pTable->pNext.load(std::memory_order_acquire) != NULL) return;
+
+	DIGEST_TABLE* pNew = CreateTable((pTable->uMask + 1) * 2);
+	DIGEST_TABLE* pExpected = NULL;
+	if(!pTable->pNext.compare_exchange_strong(pExpected, pNew, std::memory_order_acq_rel))
+		DestroyTable(pNew); // Another thread was faster
+}
+
+// Returns true if the digest has been inserted into pTable or a newer table
+bool CSHA1DigestSet::InsertInto(DIGEST_TABLE* pTable, const UINT_8* pbHash20)
+{
+	size_t i = SHA1DigestSlot(pbHash20, pTable->uMask);
+
+	while(true)
+	{
+		DIGEST_SLOT& slot = pTable->pSlots[i];
+		UINT_32 uState = slot.uState.load(std::memory_order_acquire);
+
+		if(uState == SHA1_SLOT_EMPTY)
+		{
+			// Once a newer table exists, free slots are frozen instead
+			// of being filled
+			const bool bGrowing = (pTable->pNext.load(std::memory_order_acquire) != NULL);
+			const UINT_32 uNewState = (bGrowing ? SHA1_SLOT_MOVED : SHA1_SLOT_BUSY);
+
+			if(!slot.uState.compare_exchange_strong(uState, uNewState,
+				std::memory_order_acq_rel)) continue; // Reevaluate the slot
+
+			if(bGrowing)
+			{
+				pTable = pTable->pNext.load(std::memory_order_acquire);
+				i = SHA1DigestSlot(pbHash20, pTable->uMask);
+				continue;
+			}
+
+			memcpy(slot.pbKey, pbHash20, 20);
+			slot.uState.store(SHA1_SLOT_FULL, std::memory_order_release);
+
+			if(pTable->uCount.fetch_add(1, std::memory_order_relaxed) >= (pTable->uMask >> 1))
+				StartGrowth(pTable);
+			return true;
+		}
+
+		if(uState == SHA1_SLOT_BUSY) { std::this_thread::yield(); continue; }
+
+		if(uState == SHA1_SLOT_MOVED) // Frozen free slot, continue in newer table
+		{
+			pTable = pTable->pNext.load(std::memory_order_acquire);
+			i = SHA1DigestSlot(pbHash20, pTable->uMask);
+			continue;
+		}
+
+		// Full slot (possibly migrated already, its key is still valid)
+		if(SHA1DigestEqual(slot.pbKey, pbHash20)) return false;
+		i = ((i + 1) & pTable->uMask);
+	}
+}
+
+void CSHA1DigestSet::MigrateSlot(DIGEST_TABLE* pTable, size_t uIndex)
+{
+	DIGEST_SLOT& slot = pTable->pSlots[uIndex];
+
+	while(true)
+	{
+		UINT_32 uState = slot.uState.load(std::memory_order_acquire);
+
+		if(uState == SHA1_SLOT_EMPTY)
+		{
+			if(slot.uState.compare_exchange_strong(uState, SHA1_SLOT_MOVED,
+				std::memory_order_acq_rel)) return;
+			continue;
+		}
+
+		if(uState == SHA1_SLOT_BUSY) { std::this_thread::yield(); continue; }
+		if((uState & SHA1_SLOT_MOVED) != 0) return;
+
+		InsertInto(pTable->pNext.load(std::memory_order_acquire), slot.pbKey);
+		slot.uState.store(SHA1_SLOT_FULL | SHA1_SLOT_MOVED, std::memory_order_release);
+		return;
+	}
+}
+
+void CSHA1DigestSet::HelpMigrate()
+{
+	DIGEST_TABLE* pTable = m_pRoot.load(std::memory_order_acquire);
+	if(pTable->pNext.load(std::memory_order_acquire) == NULL) return;
+
+	const size_t uSize = pTable->uMask + 1;
+	const size_t uStart = pTable->uMigrateNext.fetch_add(SHA1_DIGESTSET_MIGRATE_CHUNK,
+		std::memory_order_relaxed);
+	if(uStart >= uSize) return;
+
+	const size_t uEnd = (((uStart + SHA1_DIGESTSET_MIGRATE_CHUNK) < uSize) ?
+		(uStart + SHA1_DIGESTSET_MIGRATE_CHUNK) : uSize);
+	for(size_t i = uStart; i < uEnd; ++i) MigrateSlot(pTable, i);
+
+	// The thread completing the migration retires the table
+	const size_t uDone = pTable->uMigrated.fetch_add(uEnd - uStart,
+		std::memory_order_acq_rel) + (uEnd - uStart);
+	if(uDone == uSize)
+		m_pRoot.compare_exchange_strong(pTable, pTable->pNext.load(std::memory_order_acquire),
+			std::memory_order_acq_rel);
+}
+
+bool CSHA1DigestSet::Insert(const UINT_8* pbHash20)
+{
+	if(pbHash20 == NULL) return false;
+
+	HelpMigrate();
+
+	if(!InsertInto(m_pRoot.load(std::memory_order_acquire), pbHash20)) return false;
+
+	m_uSize.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool CSHA1DigestSet::Contains(const UINT_8* pbHash20) const
+{
+	if(pbHash20 == NULL) return false;
+
+	const DIGEST_TABLE* pTable = m_pRoot.load(std::memory_order_acquire);
+	size_t i = SHA1DigestSlot(pbHash20, pTable->uMask);
+
+	while(true)
+	{
+		const DIGEST_SLOT& slot = pTable->pSlots[i];
+		const UINT_32 uState = slot.uState.load(std::memory_order_acquire);
+
+		if(uState == SHA1_SLOT_EMPTY) return false;
+		if(uState == SHA1_SLOT_BUSY) { std::this_thread::yield(); continue; }
+
+		if(uState == SHA1_SLOT_MOVED)
+		{
+			pTable = pTable->pNext.load(std::memory_order_acquire);
+			i = SHA1DigestSlot(pbHash20, pTable->uMask);
+			continue;
+		}
+
+		if(SHA1DigestEqual(slot.pbKey, pbHash20)) return true;
+		i = ((i + 1) & pTable->uMask);
+	}
+}
+
+void CSHA1DigestSet::ReleaseRetired()
+{
+	DIGEST_TABLE* pRoot = m_pRoot.load();
+	while(m_pFirst != pRoot)
+	{
+		DIGEST_TABLE* pNext = m_pFirst->pNext.load();
+		DestroyTable(m_pFirst);
+		m_pFirst = pNext;
+	}
+}
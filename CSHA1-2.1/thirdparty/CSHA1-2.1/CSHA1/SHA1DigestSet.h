@@ -0,0 +1,84 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Concurrent set of 20-byte SHA-1 digests. See SHA1.h for version
+  history.
+
+  The set is an open-addressing table with linear probing. The digest
+  bits are used directly as the hash value. Each slot occupies 32 bytes
+  (two slots per cache line) and keys are compared using SSE2 if
+  available. Insertions claim a slot with a single compare-and-swap, so
+  any number of threads can insert and look up digests concurrently
+  without locks.
+
+  The table grows online: when it is half full, a table of twice the size
+  is appended and the entries are migrated incrementally by the threads
+  that use the set. Lookups and insertions follow frozen slots into the
+  newer table while the migration is in progress. Superseded tables are
+  kept until ReleaseRetired is called or the set is destroyed.
+*/
+
+#ifndef SHA1DIGESTSET_H_9B8CDFC08C6540B99FEDC665DA3605BC
+#define SHA1DIGESTSET_H_9B8CDFC08C6540B99FEDC665DA3605BC
+
+#include <atomic>
+
+#include "SHA1.h"
+
+class CSHA1DigestSet
+{
+public:
+	explicit CSHA1DigestSet(size_t uInitialCapacity = 1024);
+	~CSHA1DigestSet();
+
+	// Returns true if the digest has been inserted and false if it was
+	// in the set already (or pbHash20 is NULL)
+	bool Insert(const UINT_8* pbHash20);
+
+	bool Contains(const UINT_8* pbHash20) const;
+
+	size_t GetSize() const { return m_uSize.load(std::memory_order_relaxed); }
+
+	// Frees fully migrated tables; must not be called concurrently with
+	// any other method
+	void ReleaseRetired();
+
+private:
+	struct DIGEST_SLOT
+	{
+		UINT_8 pbKey[20];
+		std::atomic<UINT_32> uState;
+		UINT_8 pbPadding[8];
+	};
+
+	struct DIGEST_TABLE
+	{
+		size_t uMask;
+		DIGEST_SLOT* pSlots;
+		void* pMemory;
+
+		std::atomic<size_t> uCount;
+		std::atomic<DIGEST_TABLE*> pNext;
+		std::atomic<size_t> uMigrateNext; // Next slot to be claimed for migration
+		std::atomic<size_t> uMigrated; // Number of frozen slots
+	};
+
+	static DIGEST_TABLE* CreateTable(size_t uCapacity);
+	static void DestroyTable(DIGEST_TABLE* pTable);
+
+	bool InsertInto(DIGEST_TABLE* pTable, const UINT_8* pbHash20);
+	void StartGrowth(DIGEST_TABLE* pTable);
+	void HelpMigrate();
+	void MigrateSlot(DIGEST_TABLE* pTable, size_t uIndex);
+
+	CSHA1DigestSet(const CSHA1DigestSet&);
+	CSHA1DigestSet& operator=(const CSHA1DigestSet&);
+
+	DIGEST_TABLE* m_pFirst; // Oldest table (owner of the chain)
+	std::atomic<DIGEST_TABLE*> m_pRoot; // Oldest table not fully migrated
+	std::atomic<size_t> m_uSize;
+};
+
+#endif // SHA1DIGESTSET_H_9B8CDFC08C6540B99FEDC665DA3605BC
@@ -0,0 +1,341 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1DupFinder.h"
+#include "SHA1BufferArena.h"
+#include "SHA1ThreadPool.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#define SHA1_FSEEK64 _fseeki64
+#else
+#define SHA1_FSEEK64 fseeko
+#endif
+
+#define SHA1_DUP_SAMPLE_SIZE 4096
+#define SHA1_DUP_BUFFER (64 * 1024)
+
+#define SHA1_DUP_STAGE_SAMPLE 0
+#define SHA1_DUP_STAGE_FULL 1
+
+// Reads exactly uLen bytes at the current position
+static bool SHA1DupRead(FILE* fp, UINT_8* pbBuf, size_t uLen)
+{
+	return (fread(pbBuf, 1, uLen, fp) == uLen);
+}
+
+CSHA1DupFinder::CSHA1DupFinder(size_t uThreads) :
+	m_uSampleSize(SHA1_DUP_SAMPLE_SIZE), m_bByteCompare(false),
+	m_bIncludeEmpty(false), m_uBytesRead(0), m_uTotalBytes(0)
+{
+	m_pPool = new CSHA1ThreadPool(uThreads);
+}
+
+CSHA1DupFinder::~CSHA1DupFinder()
+{
+	delete m_pPool;
+}
+
+void CSHA1DupFinder::AddFile(const TCHAR* tszFileName)
+{
+	if(tszFileName == NULL) return;
+	m_vPaths.push_back(tszFileName);
+}
+
+void CSHA1DupFinder::Clear()
+{
+	m_vPaths.clear();
+	m_vFiles.clear();
+}
+
+bool CSHA1DupFinder::HashSample(DUP_FILE& f)
+{
+	UINT_8* pbBuf = CSHA1BufferArena::GetThreadArena().Acquire(m_uSampleSize);
+	if(pbBuf == NULL) return false;
+
+	FILE* fp = _tfopen(m_vPaths[f.vPaths[0]].c_str(), _T("rb"));
+	if(fp == NULL) return false;
+	setvbuf(fp, NULL, _IONBF, 0);
+
+	CSHA1 sha1;
+
+	bool bSuccess = SHA1DupRead(fp, pbBuf, m_uSampleSize);
+	if(bSuccess)
+	{
+		sha1.Update(pbBuf, m_uSampleSize);
+
+		bSuccess = ((SHA1_FSEEK64(fp, static_cast<INT_64>(f.id.uSize -
+			m_uSampleSize), SEEK_SET) == 0) && SHA1DupRead(fp, pbBuf, m_uSampleSize));
+		if(bSuccess) sha1.Update(pbBuf, m_uSampleSize);
+	}
+
+	fclose(fp);
+	m_uBytesRead += (static_cast<UINT_64>(m_uSampleSize) << 1);
+	if(!bSuccess) return false;
+
+	sha1.Final();
+	sha1.GetHash(f.pbSample);
+	return true;
+}
+
+bool CSHA1DupFinder::HashFull(DUP_FILE& f)
+{
+	UINT_8* pbBuf = CSHA1BufferArena::GetThreadArena().Acquire(SHA1_DUP_BUFFER);
+	if(pbBuf == NULL) return false;
+
+	FILE* fp = _tfopen(m_vPaths[f.vPaths[0]].c_str(), _T("rb"));
+	if(fp == NULL) return false;
+	setvbuf(fp, NULL, _IONBF, 0);
+
+	CSHA1 sha1;
+
+	UINT_64 uTotal = 0;
+	while(true)
+	{
+		const size_t uRead = fread(pbBuf, 1, SHA1_DUP_BUFFER, fp);
+		if(uRead > 0) sha1.Update(pbBuf, static_cast<UINT_32>(uRead));
+		uTotal += uRead;
+
+		if(uRead < SHA1_DUP_BUFFER) break;
+	}
+
+	const bool bSuccess = ((feof(fp) != 0) && (uTotal == f.id.uSize));
+	fclose(fp);
+	m_uBytesRead += uTotal;
+	if(!bSuccess) return false;
+
+	sha1.Final();
+	sha1.GetHash(f.pbHash);
+	return true;
+}
+
+bool CSHA1DupFinder::IsEqualContent(const DUP_FILE& a, const DUP_FILE& b)
+{
+	UINT_8* pbBufA = CSHA1BufferArena::GetThreadArena().Acquire(SHA1_DUP_BUFFER * 2);
+	if(pbBufA == NULL) return false;
+	UINT_8* pbBufB = pbBufA + SHA1_DUP_BUFFER;
+
+	FILE* fpA = _tfopen(m_vPaths[a.vPaths[0]].c_str(), _T("rb"));
+	if(fpA == NULL) return false;
+	FILE* fpB = _tfopen(m_vPaths[b.vPaths[0]].c_str(), _T("rb"));
+	if(fpB == NULL) { fclose(fpA); return false; }
+	setvbuf(fpA, NULL, _IONBF, 0);
+	setvbuf(fpB, NULL, _IONBF, 0);
+
+	bool bEqual = true;
+	UINT_64 uRemaining = a.id.uSize;
+	while(uRemaining != 0)
+	{
+		const size_t uLen = ((uRemaining < SHA1_DUP_BUFFER) ?
+			static_cast<size_t>(uRemaining) : SHA1_DUP_BUFFER);
+
+		if(!SHA1DupRead(fpA, pbBufA, uLen) || !SHA1DupRead(fpB, pbBufB, uLen) ||
+			(memcmp(pbBufA, pbBufB, uLen) != 0))
+		{
+			bEqual = false;
+			break;
+		}
+
+		m_uBytesRead += (static_cast<UINT_64>(uLen) << 1);
+		uRemaining -= uLen;
+	}
+
+	fclose(fpB);
+	fclose(fpA);
+	return bEqual;
+}
+
+void CSHA1DupFinder::ForEachFile(const std::vector<DUP_CANDIDATES>& vGroups, int iStage)
+{
+	for(size_t g = 0; g < vGroups.size(); ++g)
+	{
+		for(size_t i = 0; i < vGroups[g].size(); ++i)
+		{
+			DUP_FILE* pFile = &m_vFiles[vGroups[g][i]];
+			m_pPool->Submit([this, pFile, iStage]()
+			{
+				if(iStage == SHA1_DUP_STAGE_SAMPLE) pFile->bValid = HashSample(*pFile);
+				else pFile->bValid = HashFull(*pFile);
+			});
+		}
+	}
+
+	m_pPool->Wait();
+}
+
+// Splits each group by the digest of the stage; drops unreadable files
+// and groups of less than 2 files
+void CSHA1DupFinder::SplitGroups(std::vector<DUP_CANDIDATES>& vGroups, int iStage)
+{
+	const std::vector<DUP_FILE>& vFiles = m_vFiles;
+	std::vector<DUP_CANDIDATES> vOut;
+
+	for(size_t g = 0; g < vGroups.size(); ++g)
+	{
+		DUP_CANDIDATES& vGroup = vGroups[g];
+		vGroup.erase(std::remove_if(vGroup.begin(), vGroup.end(), [&vFiles](size_t i)
+			{ return !vFiles[i].bValid; }), vGroup.end());
+
+		auto fnKey = [&vFiles, iStage](size_t i) -> const UINT_8*
+			{ return ((iStage == SHA1_DUP_STAGE_SAMPLE) ? vFiles[i].pbSample : vFiles[i].pbHash); };
+		std::sort(vGroup.begin(), vGroup.end(), [&fnKey](size_t a, size_t b)
+			{ return (memcmp(fnKey(a), fnKey(b), 20) < 0); });
+
+		size_t uStart = 0;
+		for(size_t i = 1; i <= vGroup.size(); ++i)
+		{
+			if((i < vGroup.size()) && (memcmp(fnKey(vGroup[uStart]), fnKey(vGroup[i]), 20) == 0))
+				continue;
+
+			if((i - uStart) >= 2)
+				vOut.push_back(DUP_CANDIDATES(vGroup.begin() + uStart, vGroup.begin() + i));
+			uStart = i;
+		}
+	}
+
+	vGroups.swap(vOut);
+}
+
+bool CSHA1DupFinder::Run(std::vector<SHA1_DUP_GROUP>& vGroupsOut)
+{
+	vGroupsOut.clear();
+	m_vFiles.clear();
+	m_uBytesRead = 0;
+	m_uTotalBytes = 0;
+
+	// Stage 1: file metadata, collapsing hard links
+	std::vector<SHA1_FILE_ID> vIds(m_vPaths.size());
+	std::vector<char> vIdValid(m_vPaths.size(), 0);
+	for(size_t i = 0; i < m_vPaths.size(); ++i)
+	{
+		SHA1_FILE_ID* pId = &vIds[i];
+		char* pValid = &vIdValid[i];
+		const TCHAR* tszPath = m_vPaths[i].c_str();
+		m_pPool->Submit([pId, pValid, tszPath]()
+			{ *pValid = (SHA1GetFileId(tszPath, *pId) ? 1 : 0); });
+	}
+	m_pPool->Wait();
+
+	std::vector<size_t> vOrder;
+	for(size_t i = 0; i < m_vPaths.size(); ++i)
+	{
+		if(vIdValid[i] == 0) continue;
+		if((vIds[i].uSize == 0) && !m_bIncludeEmpty) continue;
+		vOrder.push_back(i);
+	}
+
+	std::sort(vOrder.begin(), vOrder.end(), [&vIds](size_t a, size_t b)
+	{
+		if(vIds[a].uSize != vIds[b].uSize) return (vIds[a].uSize < vIds[b].uSize);
+		if(vIds[a].uDevice != vIds[b].uDevice) return (vIds[a].uDevice < vIds[b].uDevice);
+		if(vIds[a].uInode != vIds[b].uInode) return (vIds[a].uInode < vIds[b].uInode);
+		return (a < b);
+	});
+
+	for(size_t i = 0; i < vOrder.size(); ++i)
+	{
+		const SHA1_FILE_ID& id = vIds[vOrder[i]];
+		if(!m_vFiles.empty() && SHA1IsSameFile(m_vFiles.back().id, id))
+		{
+			m_vFiles.back().vPaths.push_back(vOrder[i]);
+			continue;
+		}
+
+		DUP_FILE f;
+		f.vPaths.push_back(vOrder[i]);
+		f.id = id;
+		f.bValid = true;
+		m_vFiles.push_back(f);
+		m_uTotalBytes += id.uSize;
+	}
+
+	// Group by size; groups of small files are hashed completely right away
+	std::vector<DUP_CANDIDATES> vSampled, vSmall;
+	size_t uStart = 0;
+	for(size_t i = 1; i <= m_vFiles.size(); ++i)
+	{
+		if((i < m_vFiles.size()) && (m_vFiles[i].id.uSize == m_vFiles[uStart].id.uSize))
+			continue;
+
+		if((i - uStart) >= 2)
+		{
+			DUP_CANDIDATES vGroup;
+			for(size_t j = uStart; j < i; ++j) vGroup.push_back(j);
+
+			if(m_vFiles[uStart].id.uSize > (static_cast<UINT_64>(m_uSampleSize) << 1))
+				vSampled.push_back(vGroup);
+			else vSmall.push_back(vGroup);
+		}
+		uStart = i;
+	}
+
+	// Stage 2: head and tail samples
+	if(m_uSampleSize != 0)
+	{
+		ForEachFile(vSampled, SHA1_DUP_STAGE_SAMPLE);
+		SplitGroups(vSampled, SHA1_DUP_STAGE_SAMPLE);
+	}
+
+	// Stage 3: full contents
+	std::vector<DUP_CANDIDATES> vFull(vSmall);
+	vFull.insert(vFull.end(), vSampled.begin(), vSampled.end());
+	ForEachFile(vFull, SHA1_DUP_STAGE_FULL);
+	SplitGroups(vFull, SHA1_DUP_STAGE_FULL);
+
+	// Stage 4: optional byte comparison against the first file of each group
+	if(m_bByteCompare)
+	{
+		std::vector<DUP_CANDIDATES> vCompared;
+		for(size_t g = 0; g < vFull.size(); ++g)
+		{
+			const DUP_CANDIDATES& vGroup = vFull[g];
+			for(size_t i = 1; i < vGroup.size(); ++i)
+			{
+				const DUP_FILE* pFirst = &m_vFiles[vGroup[0]];
+				DUP_FILE* pFile = &m_vFiles[vGroup[i]];
+				m_pPool->Submit([this, pFirst, pFile]()
+					{ pFile->bValid = IsEqualContent(*pFirst, *pFile); });
+			}
+		}
+		m_pPool->Wait();
+
+		for(size_t g = 0; g < vFull.size(); ++g)
+		{
+			DUP_CANDIDATES vGroup(1, vFull[g][0]);
+			for(size_t i = 1; i < vFull[g].size(); ++i)
+			{
+				if(m_vFiles[vFull[g][i]].bValid) vGroup.push_back(vFull[g][i]);
+			}
+
+			if(vGroup.size() >= 2) vCompared.push_back(vGroup);
+		}
+
+		vFull.swap(vCompared);
+	}
+
+	for(size_t g = 0; g < vFull.size(); ++g)
+	{
+		SHA1_DUP_GROUP grp;
+		const DUP_FILE& fFirst = m_vFiles[vFull[g][0]];
+		grp.uFileSize = fFirst.id.uSize;
+		memcpy(grp.pbHash, fFirst.pbHash, 20);
+
+		for(size_t i = 0; i < vFull[g].size(); ++i)
+		{
+			const DUP_FILE& f = m_vFiles[vFull[g][i]];
+			for(size_t j = 0; j < f.vPaths.size(); ++j)
+				grp.vPaths.push_back(m_vPaths[f.vPaths[j]]);
+		}
+
+		vGroupsOut.push_back(grp);
+	}
+
+	return true;
+}
@@ -0,0 +1,93 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Duplicate file finder. See SHA1.h for version history.
+
+  Files are filtered in stages, each one running in parallel and only
+  looking at the files that are still candidates:
+  1. Group by size (no file data is read); hard links to the same file
+     are recognized by device and inode and read only once.
+  2. Hash a sample of the head and tail of each file.
+  3. Hash the full contents of the files whose samples collide.
+  4. Optionally compare the remaining files byte by byte.
+*/
+
+#ifndef SHA1DUPFINDER_H_0E4C3A1F9B2D4E6A8C1F3B5D7E9A2C4F
+#define SHA1DUPFINDER_H_0E4C3A1F9B2D4E6A8C1F3B5D7E9A2C4F
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "SHA1.h"
+#include "SHA1FileInfo.h"
+
+class CSHA1ThreadPool;
+
+typedef struct
+{
+	UINT_64 uFileSize;
+	UINT_8 pbHash[20];
+	std::vector<std::basic_string<TCHAR> > vPaths;
+} SHA1_DUP_GROUP;
+
+class CSHA1DupFinder
+{
+public:
+	// If uThreads is 0, one thread per hardware thread is used
+	explicit CSHA1DupFinder(size_t uThreads = 0);
+	~CSHA1DupFinder();
+
+	// Bytes hashed from both the head and the tail of candidate files
+	void SetSampleSize(UINT_32 uSampleSize) { m_uSampleSize = uSampleSize; }
+	void SetByteCompare(bool bCompare) { m_bByteCompare = bCompare; }
+	void SetIncludeEmpty(bool bInclude) { m_bIncludeEmpty = bInclude; }
+
+	void AddFile(const TCHAR* tszFileName);
+	void Clear();
+
+	// Groups of files with identical contents (at least 2 distinct files)
+	bool Run(std::vector<SHA1_DUP_GROUP>& vGroupsOut);
+
+	// Statistics of the last run
+	UINT_64 GetBytesRead() const { return m_uBytesRead.load(); }
+	UINT_64 GetTotalBytes() const { return m_uTotalBytes; }
+
+private:
+	struct DUP_FILE
+	{
+		std::vector<size_t> vPaths; // Hard links to the same file
+		SHA1_FILE_ID id;
+		UINT_8 pbSample[20];
+		UINT_8 pbHash[20];
+		bool bValid;
+	};
+
+	typedef std::vector<size_t> DUP_CANDIDATES;
+
+	bool HashSample(DUP_FILE& f);
+	bool HashFull(DUP_FILE& f);
+	bool IsEqualContent(const DUP_FILE& a, const DUP_FILE& b);
+
+	void ForEachFile(const std::vector<DUP_CANDIDATES>& vGroups, int iStage);
+	void SplitGroups(std::vector<DUP_CANDIDATES>& vGroups, int iStage);
+
+	CSHA1DupFinder(const CSHA1DupFinder&);
+	CSHA1DupFinder& operator=(const CSHA1DupFinder&);
+
+	std::vector<std::basic_string<TCHAR> > m_vPaths;
+	std::vector<DUP_FILE> m_vFiles;
+
+	UINT_32 m_uSampleSize;
+	bool m_bByteCompare;
+	bool m_bIncludeEmpty;
+
+	std::atomic<UINT_64> m_uBytesRead;
+	UINT_64 m_uTotalBytes;
+
+	CSHA1ThreadPool* m_pPool;
+};
+
+#endif // SHA1DUPFINDER_H_0E4C3A1F9B2D4E6A8C1F3B5D7E9A2C4F
@@ -0,0 +1,313 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#include "SHA1Encode.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SHA1_ENCODE_SSE2
+#include <emmintrin.h>
+#endif
+
+static const char g_pchHexLower[] = "0123456789abcdef";
+static const char g_pchHexUpper[] = "0123456789ABCDEF";
+static const char g_pchBase32[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+static const char g_pchBase64Url[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// Reverse lookup tables; 0xFF marks invalid characters
+class CSHA1DecodeTables
+{
+public:
+	CSHA1DecodeTables()
+	{
+		memset(m_pbHex, 0xFF, 256);
+		memset(m_pbBase32, 0xFF, 256);
+		memset(m_pbBase64Url, 0xFF, 256);
+
+		for(UINT_8 i = 0; i < 16; ++i)
+		{
+			m_pbHex[static_cast<UINT_8>(g_pchHexLower[i])] = i;
+			m_pbHex[static_cast<UINT_8>(g_pchHexUpper[i])] = i;
+		}
+		for(UINT_8 i = 0; i < 32; ++i)
+		{
+			m_pbBase32[static_cast<UINT_8>(g_pchBase32[i])] = i;
+			if(i < 26) m_pbBase32[static_cast<UINT_8>('a' + i)] = i;
+		}
+		for(UINT_8 i = 0; i < 64; ++i)
+			m_pbBase64Url[static_cast<UINT_8>(g_pchBase64Url[i])] = i;
+	}
+
+	UINT_8 m_pbHex[256];
+	UINT_8 m_pbBase32[256];
+	UINT_8 m_pbBase64Url[256];
+};
+
+static const CSHA1DecodeTables g_decTables;
+
+///////////////////////////////////////////////////////////////////////////
+// Encoding
+
+static void SHA1EncodeHex(const UINT_8* pb, char* pch, bool bUpper)
+{
+	const char* pchDigits = (bUpper ? g_pchHexUpper : g_pchHexLower);
+	size_t i = 0;
+
+#ifdef SHA1_ENCODE_SSE2
+	// Bytes 0-15: split into nibbles, interleave and map 10-15 to letters
+	const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb));
+	const __m128i mNibble = _mm_set1_epi8(0x0F);
+	const __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), mNibble);
+	const __m128i lo = _mm_and_si128(x, mNibble);
+
+	const __m128i mNine = _mm_set1_epi8(9);
+	const __m128i mZero = _mm_set1_epi8('0');
+	const __m128i mLetter = _mm_set1_epi8(static_cast<char>(bUpper ? ('A' - '0' - 10) :
+		('a' - '0' - 10)));
+
+	__m128i n = _mm_unpacklo_epi8(hi, lo);
+	n = _mm_add_epi8(_mm_add_epi8(n, mZero), _mm_and_si128(_mm_cmpgt_epi8(n, mNine), mLetter));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(pch), n);
+
+	n = _mm_unpackhi_epi8(hi, lo);
+	n = _mm_add_epi8(_mm_add_epi8(n, mZero), _mm_and_si128(_mm_cmpgt_epi8(n, mNine), mLetter));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(&pch[16]), n);
+
+	i = 16;
+#endif
+
+	for( ; i < 20; ++i)
+	{
+		pch[i << 1] = pchDigits[pb[i] >> 4];
+		pch[(i << 1) + 1] = pchDigits[pb[i] & 0x0F];
+	}
+}
+
+static void SHA1EncodeHexSpaced(const UINT_8* pb, char* pch, bool bUpper)
+{
+	const char* pchDigits = (bUpper ? g_pchHexUpper : g_pchHexLower);
+
+	pch[0] = pchDigits[pb[0] >> 4];
+	pch[1] = pchDigits[pb[0] & 0x0F];
+	for(size_t i = 1; i < 20; ++i)
+	{
+		char* p = &pch[(i * 3) - 1];
+		p[0] = ' ';
+		p[1] = pchDigits[pb[i] >> 4];
+		p[2] = pchDigits[pb[i] & 0x0F];
+	}
+}
+
+static void SHA1EncodeBase32(const UINT_8* pb, char* pch)
+{
+	for(size_t g = 0; g < 4; ++g) // 4 groups of 5 bytes = 8 characters
+	{
+		const UINT_8* s = &pb[g * 5];
+		const UINT_64 u = (static_cast<UINT_64>(s[0]) << 32) | (static_cast<UINT_64>(s[1]) << 24) |
+			(static_cast<UINT_64>(s[2]) << 16) | (static_cast<UINT_64>(s[3]) << 8) | s[4];
+
+		char* d = &pch[g * 8];
+		for(size_t i = 0; i < 8; ++i)
+			d[i] = g_pchBase32[(u >> (35 - (i * 5))) & 0x1F];
+	}
+}
+
+static void SHA1EncodeBase64Url(const UINT_8* pb, char* pch)
+{
+	for(size_t g = 0; g < 6; ++g) // 6 groups of 3 bytes = 4 characters
+	{
+		const UINT_8* s = &pb[g * 3];
+		const UINT_32 u = (static_cast<UINT_32>(s[0]) << 16) |
+			(static_cast<UINT_32>(s[1]) << 8) | s[2];
+
+		char* d = &pch[g * 4];
+		d[0] = g_pchBase64Url[(u >> 18) & 0x3F];
+		d[1] = g_pchBase64Url[(u >> 12) & 0x3F];
+		d[2] = g_pchBase64Url[(u >> 6) & 0x3F];
+		d[3] = g_pchBase64Url[u & 0x3F];
+	}
+
+	// Remaining 2 bytes = 3 characters
+	const UINT_32 u = (static_cast<UINT_32>(pb[18]) << 8) | pb[19];
+	pch[24] = g_pchBase64Url[(u >> 10) & 0x3F];
+	pch[25] = g_pchBase64Url[(u >> 4) & 0x3F];
+	pch[26] = g_pchBase64Url[(u << 2) & 0x3F];
+}
+
+size_t SHA1EncodedLength(SHA1_ENCODING enc)
+{
+	switch(enc)
+	{
+	case SHA1_ENC_HEX_LOWER:
+	case SHA1_ENC_HEX_UPPER: return 40;
+	case SHA1_ENC_HEX_LOWER_SPACED:
+	case SHA1_ENC_HEX_UPPER_SPACED: return 59;
+	case SHA1_ENC_BASE32: return 32;
+	case SHA1_ENC_BASE64URL: return 27;
+	default: break;
+	}
+
+	return 0;
+}
+
+size_t SHA1EncodeDigest(const UINT_8* pbHash20, char* pchOut, SHA1_ENCODING enc)
+{
+	if((pbHash20 == NULL) || (pchOut == NULL)) return 0;
+
+	switch(enc)
+	{
+	case SHA1_ENC_HEX_LOWER: SHA1EncodeHex(pbHash20, pchOut, false); break;
+	case SHA1_ENC_HEX_UPPER: SHA1EncodeHex(pbHash20, pchOut, true); break;
+	case SHA1_ENC_HEX_LOWER_SPACED: SHA1EncodeHexSpaced(pbHash20, pchOut, false); break;
+	case SHA1_ENC_HEX_UPPER_SPACED: SHA1EncodeHexSpaced(pbHash20, pchOut, true); break;
+	case SHA1_ENC_BASE32: SHA1EncodeBase32(pbHash20, pchOut); break;
+	case SHA1_ENC_BASE64URL: SHA1EncodeBase64Url(pbHash20, pchOut); break;
+	default: return 0;
+	}
+
+	return SHA1EncodedLength(enc);
+}
+
+size_t SHA1EncodeDigests(const UINT_8* pbHashes, size_t uCount, char* pchOut,
+	SHA1_ENCODING enc, char chSeparator)
+{
+	if((pbHashes == NULL) || (pchOut == NULL)) return 0;
+
+	const size_t uLen = SHA1EncodedLength(enc);
+	if(uLen == 0) return 0;
+
+	char* pch = pchOut;
+	for(size_t i = 0; i < uCount; ++i)
+	{
+		SHA1EncodeDigest(&pbHashes[i * 20], pch, enc);
+		pch += uLen;
+
+		if(chSeparator != 0) *pch++ = chSeparator;
+	}
+
+	return static_cast<size_t>(pch - pchOut);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Decoding
+
+static bool SHA1DecodeHex(const char* pch, UINT_8* pb, size_t uStride)
+{
+	const UINT_8* pbTable = g_decTables.m_pbHex;
+
+	UINT_8 uInvalid = 0;
+	for(size_t i = 0; i < 20; ++i)
+	{
+		const UINT_8 h = pbTable[static_cast<UINT_8>(pch[i * uStride])];
+		const UINT_8 l = pbTable[static_cast<UINT_8>(pch[(i * uStride) + 1])];
+		uInvalid |= (h | l);
+		pb[i] = static_cast<UINT_8>((h << 4) | (l & 0x0F));
+	}
+
+	return ((uInvalid & 0xF0) == 0);
+}
+
+static bool SHA1DecodeBase32(const char* pch, UINT_8* pb)
+{
+	const UINT_8* pbTable = g_decTables.m_pbBase32;
+
+	for(size_t g = 0; g < 4; ++g)
+	{
+		UINT_64 u = 0;
+		for(size_t i = 0; i < 8; ++i)
+		{
+			const UINT_8 v = pbTable[static_cast<UINT_8>(pch[(g * 8) + i])];
+			if(v == 0xFF) return false;
+			u = (u << 5) | v;
+		}
+
+		UINT_8* d = &pb[g * 5];
+		d[0] = static_cast<UINT_8>(u >> 32);
+		d[1] = static_cast<UINT_8>(u >> 24);
+		d[2] = static_cast<UINT_8>(u >> 16);
+		d[3] = static_cast<UINT_8>(u >> 8);
+		d[4] = static_cast<UINT_8>(u);
+	}
+
+	return true;
+}
+
+static bool SHA1DecodeBase64Url(const char* pch, UINT_8* pb)
+{
+	const UINT_8* pbTable = g_decTables.m_pbBase64Url;
+
+	UINT_32 u = 0;
+	size_t uBits = 0, uOut = 0;
+	for(size_t i = 0; i < 27; ++i)
+	{
+		const UINT_8 v = pbTable[static_cast<UINT_8>(pch[i])];
+		if(v == 0xFF) return false;
+
+		u = (u << 6) | v;
+		uBits += 6;
+		if(uBits >= 8)
+		{
+			uBits -= 8;
+			pb[uOut++] = static_cast<UINT_8>((u >> uBits) & 0xFF);
+		}
+	}
+
+	// The 2 unused low bits of the last character must be zero
+	return ((u & 0x03) == 0);
+}
+
+bool SHA1DecodeDigest(const char* pchIn, size_t uLen, UINT_8* pbHash20Out,
+	SHA1_ENCODING enc)
+{
+	if((pchIn == NULL) || (pbHash20Out == NULL)) return false;
+	if((uLen != SHA1EncodedLength(enc)) || (uLen == 0)) return false;
+
+	switch(enc)
+	{
+	case SHA1_ENC_HEX_LOWER:
+	case SHA1_ENC_HEX_UPPER:
+		return SHA1DecodeHex(pchIn, pbHash20Out, 2);
+
+	case SHA1_ENC_HEX_LOWER_SPACED:
+	case SHA1_ENC_HEX_UPPER_SPACED:
+		for(size_t i = 2; i < 59; i += 3)
+		{
+			if(pchIn[i] != ' ') return false;
+		}
+		return SHA1DecodeHex(pchIn, pbHash20Out, 3);
+
+	case SHA1_ENC_BASE32: return SHA1DecodeBase32(pchIn, pbHash20Out);
+	case SHA1_ENC_BASE64URL: return SHA1DecodeBase64Url(pchIn, pbHash20Out);
+	default: break;
+	}
+
+	return false;
+}
+
+size_t SHA1DecodeDigests(const char* pchIn, size_t uLen, size_t uCount,
+	UINT_8* pbHashesOut, SHA1_ENCODING enc, char chSeparator)
+{
+	if((pchIn == NULL) || (pbHashesOut == NULL)) return 0;
+
+	const size_t uDigestLen = SHA1EncodedLength(enc);
+	if(uDigestLen == 0) return 0;
+	const size_t uStride = uDigestLen + ((chSeparator != 0) ? 1 : 0);
+
+	size_t i = 0;
+	for( ; i < uCount; ++i)
+	{
+		const size_t uPos = i * uStride;
+		if((uPos + uDigestLen) > uLen) break;
+
+		if(!SHA1DecodeDigest(&pchIn[uPos], uDigestLen, &pbHashesOut[i * 20], enc)) break;
+		if((chSeparator != 0) && ((uPos + uDigestLen) < uLen) &&
+			(pchIn[uPos + uDigestLen] != chSeparator)) break;
+	}
+
+	return i;
+}
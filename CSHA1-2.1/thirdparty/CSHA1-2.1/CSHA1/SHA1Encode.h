@@ -0,0 +1,51 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Allocation-free text encoding and decoding of SHA-1 digests.
+  See SHA1.h for version history.
+
+  All functions write into caller-supplied buffers and do not append a
+  terminating zero; use SHA1EncodedLength to size the buffers. Hex
+  encoding uses SSE2 if available. The bulk functions process arrays of
+  consecutive 20-byte digests (for example GetHash outputs stored in one
+  array).
+*/
+
+#ifndef SHA1ENCODE_H_3B744289C519416AAB27055F6B0F1C41
+#define SHA1ENCODE_H_3B744289C519416AAB27055F6B0F1C41
+
+#include "SHA1.h"
+
+enum SHA1_ENCODING
+{
+	SHA1_ENC_HEX_LOWER = 0, // 40 characters
+	SHA1_ENC_HEX_UPPER = 1,
+	SHA1_ENC_HEX_LOWER_SPACED = 2, // 59 characters, "a9 99 3e ..."
+	SHA1_ENC_HEX_UPPER_SPACED = 3,
+	SHA1_ENC_BASE32 = 4, // 32 characters, RFC 4648 alphabet
+	SHA1_ENC_BASE64URL = 5 // 27 characters, RFC 4648 URL-safe, no padding
+};
+
+// Number of characters of an encoded digest (0 for invalid encodings)
+size_t SHA1EncodedLength(SHA1_ENCODING enc);
+
+// Returns the number of characters written
+size_t SHA1EncodeDigest(const UINT_8* pbHash20, char* pchOut, SHA1_ENCODING enc);
+
+// Encodes uCount digests; if chSeparator is not 0, it is written after
+// each digest. Returns the number of characters written.
+size_t SHA1EncodeDigests(const UINT_8* pbHashes, size_t uCount, char* pchOut,
+	SHA1_ENCODING enc, char chSeparator = '\n');
+
+// Decoding accepts both letter cases for hex and Base32
+bool SHA1DecodeDigest(const char* pchIn, size_t uLen, UINT_8* pbHash20Out,
+	SHA1_ENCODING enc);
+
+// Decodes uCount digests written by SHA1EncodeDigests with the same
+// separator. Returns the number of digests decoded before the first error.
+size_t SHA1DecodeDigests(const char* pchIn, size_t uLen, size_t uCount,
+	UINT_8* pbHashesOut, SHA1_ENCODING enc, char chSeparator = '\n');
+
+#endif // SHA1ENCODE_H_3B744289C519416AAB27055F6B0F1C41
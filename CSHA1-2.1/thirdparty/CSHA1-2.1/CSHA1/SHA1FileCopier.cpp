@@ -0,0 +1,374 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1FileCopier.h"
+#include "SHA1BufferArena.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define SHA1_COPY_NO_FILE INVALID_HANDLE_VALUE
+typedef HANDLE SHA1_COPY_FILE;
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#define SHA1_COPY_NO_FILE (-1)
+typedef int SHA1_COPY_FILE;
+#endif
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Alignment of the buffers and chunk sizes, as required for direct I/O
+#define SHA1_COPY_ALIGN 4096
+
+///////////////////////////////////////////////////////////////////////////
+// Platform helpers
+
+#ifdef _WIN32
+
+static SHA1_COPY_FILE SHA1CopyOpenRead(const TCHAR* tszFileName, bool bDirect)
+{
+	return CreateFile(tszFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN | (bDirect ? FILE_FLAG_NO_BUFFERING : 0), NULL);
+}
+
+// The destination is truncated only after checking that it is not the
+// source itself (or another link to it)
+static SHA1_COPY_FILE SHA1CopyCreate(const TCHAR* tszFileName, SHA1_COPY_FILE hSource)
+{
+	const HANDLE hFile = CreateFile(tszFileName, GENERIC_WRITE | FILE_READ_ATTRIBUTES, 0,
+		NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(hFile == INVALID_HANDLE_VALUE) return SHA1_COPY_NO_FILE;
+
+	BY_HANDLE_FILE_INFORMATION fiSource, fiDest;
+	bool bOK = ((GetFileInformationByHandle(hSource, &fiSource) != FALSE) &&
+		(GetFileInformationByHandle(hFile, &fiDest) != FALSE));
+	if(bOK && (fiSource.dwVolumeSerialNumber == fiDest.dwVolumeSerialNumber) &&
+		(fiSource.nFileIndexHigh == fiDest.nFileIndexHigh) &&
+		(fiSource.nFileIndexLow == fiDest.nFileIndexLow))
+	{
+		SetLastError(ERROR_INVALID_PARAMETER);
+		bOK = false;
+	}
+	if(bOK) bOK = (SetEndOfFile(hFile) != FALSE);
+
+	if(!bOK) { CloseHandle(hFile); return SHA1_COPY_NO_FILE; }
+	return hFile;
+}
+
+static bool SHA1CopyRead(SHA1_COPY_FILE hFile, UINT_8* pbBuf, size_t uLen, size_t& uRead)
+{
+	DWORD dwRead = 0;
+	if(ReadFile(hFile, pbBuf, static_cast<DWORD>(uLen), &dwRead, NULL) == FALSE) return false;
+	uRead = dwRead;
+	return true;
+}
+
+static bool SHA1CopyWrite(SHA1_COPY_FILE hFile, const UINT_8* pbData, size_t uLen)
+{
+	while(uLen != 0)
+	{
+		DWORD dwWritten = 0;
+		if(WriteFile(hFile, pbData, static_cast<DWORD>(uLen), &dwWritten, NULL) == FALSE) return false;
+		if(dwWritten == 0) return false;
+
+		pbData += dwWritten;
+		uLen -= dwWritten;
+	}
+
+	return true;
+}
+
+static bool SHA1CopyClose(SHA1_COPY_FILE hFile, bool bSync)
+{
+	bool bResult = true;
+	if(bSync) bResult = (FlushFileBuffers(hFile) != FALSE);
+	if(CloseHandle(hFile) == FALSE) bResult = false;
+	return bResult;
+}
+
+static void SHA1CopyRemove(const TCHAR* tszFileName)
+{
+	DeleteFile(tszFileName);
+}
+
+#else // !_WIN32
+
+static SHA1_COPY_FILE SHA1CopyOpenRead(const TCHAR* tszFileName, bool bDirect)
+{
+	int iFlags = O_RDONLY | O_CLOEXEC;
+#ifdef O_DIRECT
+	if(bDirect) iFlags |= O_DIRECT;
+#else
+	if(bDirect) { errno = EINVAL; return SHA1_COPY_NO_FILE; }
+#endif
+
+	const int fd = open(tszFileName, iFlags);
+	if(fd < 0) return SHA1_COPY_NO_FILE;
+
+#if defined(F_NOCACHE) && !defined(O_DIRECT)
+	if(bDirect) fcntl(fd, F_NOCACHE, 1);
+#endif
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	return fd;
+}
+
+// The destination is truncated only after checking that it is not the
+// source itself (or another link to it)
+static SHA1_COPY_FILE SHA1CopyCreate(const TCHAR* tszFileName, SHA1_COPY_FILE hSource)
+{
+	const int fd = open(tszFileName, O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+	if(fd < 0) return SHA1_COPY_NO_FILE;
+
+	struct stat stSource, stDest;
+	bool bOK = ((fstat(hSource, &stSource) == 0) && (fstat(fd, &stDest) == 0));
+	if(bOK && (stSource.st_dev == stDest.st_dev) && (stSource.st_ino == stDest.st_ino))
+	{
+		errno = EINVAL;
+		bOK = false;
+	}
+	if(bOK) bOK = (ftruncate(fd, 0) == 0);
+
+	if(!bOK) { close(fd); return SHA1_COPY_NO_FILE; }
+	return fd;
+}
+
+static bool SHA1CopyRead(SHA1_COPY_FILE fd, UINT_8* pbBuf, size_t uLen, size_t& uRead)
+{
+	while(true)
+	{
+		const ssize_t iRead = read(fd, pbBuf, uLen);
+		if(iRead >= 0) { uRead = static_cast<size_t>(iRead); return true; }
+		if(errno != EINTR) return false;
+	}
+}
+
+static bool SHA1CopyWrite(SHA1_COPY_FILE fd, const UINT_8* pbData, size_t uLen)
+{
+	while(uLen != 0)
+	{
+		const ssize_t iWritten = write(fd, pbData, uLen);
+		if(iWritten < 0)
+		{
+			if(errno == EINTR) continue;
+			return false;
+		}
+		if(iWritten == 0) return false;
+
+		pbData += iWritten;
+		uLen -= static_cast<size_t>(iWritten);
+	}
+
+	return true;
+}
+
+static bool SHA1CopyClose(SHA1_COPY_FILE fd, bool bSync)
+{
+	bool bResult = true;
+	if(bSync) bResult = (fsync(fd) == 0);
+	if(close(fd) != 0) bResult = false;
+	return bResult;
+}
+
+static void SHA1CopyRemove(const TCHAR* tszFileName)
+{
+	unlink(tszFileName);
+}
+
+#endif // _WIN32
+
+// Reads until the buffer is full or the end of the file is reached
+static bool SHA1CopyReadFull(SHA1_COPY_FILE hFile, UINT_8* pbBuf, size_t uLen, size_t& uRead)
+{
+	uRead = 0;
+	while(uRead < uLen)
+	{
+		size_t uPart = 0;
+		if(!SHA1CopyRead(hFile, pbBuf + uRead, uLen - uRead, uPart)) return false;
+		if(uPart == 0) break;
+		uRead += uPart;
+	}
+
+	return true;
+}
+
+CSHA1FileCopier::CSHA1FileCopier(UINT_32 uChunkSize, size_t uBuffers) :
+	m_bVerify(false), m_bSync(false)
+{
+	if(uChunkSize == 0) uChunkSize = SHA1_COPY_ALIGN;
+	m_uChunkSize = (uChunkSize + (SHA1_COPY_ALIGN - 1)) & ~static_cast<UINT_32>(SHA1_COPY_ALIGN - 1);
+	m_uBuffers = ((uBuffers >= 2) ? uBuffers : 2);
+}
+
+bool CSHA1FileCopier::Copy(const TCHAR* tszSource, const TCHAR* tszDest,
+	SHA1_COPY_RESULT& resultOut)
+{
+	memset(&resultOut, 0, sizeof(resultOut));
+	if((tszSource == NULL) || (tszDest == NULL)) return false;
+
+	// Arena buffers are page aligned, as required for direct I/O
+	UINT_8* pbBuffers = CSHA1BufferArena::GetThreadArena().Acquire(m_uBuffers * m_uChunkSize);
+	if(pbBuffers == NULL) return false;
+
+	const SHA1_COPY_FILE hSource = SHA1CopyOpenRead(tszSource, false);
+	if(hSource == SHA1_COPY_NO_FILE) return false;
+
+	const SHA1_COPY_FILE hDest = SHA1CopyCreate(tszDest, hSource);
+	if(hDest == SHA1_COPY_NO_FILE) { SHA1CopyClose(hSource, false); return false; }
+
+	std::vector<size_t> vLengths(m_uBuffers, 0);
+
+	// Chunk k is held in buffer k % m_uBuffers
+	std::mutex mtx;
+	std::condition_variable cv;
+	UINT_64 uRead = 0, uHashed = 0, uWritten = 0;
+	bool bEof = false, bError = false;
+
+	const size_t uBuffers = m_uBuffers;
+	const size_t uChunkSize = m_uChunkSize;
+
+	std::thread thReader([&]()
+	{
+		for(UINT_64 k = 0; ; ++k)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				while(!bError && ((k - ((uHashed < uWritten) ? uHashed : uWritten)) >= uBuffers))
+					cv.wait(lock);
+				if(bError) return;
+			}
+
+			const size_t b = static_cast<size_t>(k % uBuffers);
+			size_t uLen = 0;
+			const bool bOK = SHA1CopyReadFull(hSource, pbBuffers + (b * uChunkSize),
+				uChunkSize, uLen);
+
+			std::lock_guard<std::mutex> lock(mtx);
+			if(!bOK) bError = true;
+			else
+			{
+				vLengths[b] = uLen;
+				if(uLen != 0) ++uRead;
+				if(uLen < uChunkSize) bEof = true;
+			}
+			cv.notify_all();
+
+			if(!bOK || bEof) return;
+		}
+	});
+
+	// Waits for chunk k; false at the end of the data or on errors
+	auto fnWaitChunk = [&](UINT_64 k) -> bool
+	{
+		std::unique_lock<std::mutex> lock(mtx);
+		while(!bError && (k >= uRead) && !bEof) cv.wait(lock);
+		return (!bError && (k < uRead));
+	};
+
+	CSHA1 sha1;
+	std::thread thHasher([&]()
+	{
+		for(UINT_64 k = 0; fnWaitChunk(k); ++k)
+		{
+			const size_t b = static_cast<size_t>(k % uBuffers);
+			sha1.Update(pbBuffers + (b * uChunkSize), static_cast<UINT_32>(vLengths[b]));
+
+			std::lock_guard<std::mutex> lock(mtx);
+			++uHashed;
+			cv.notify_all();
+		}
+	});
+
+	UINT_64 uBytes = 0;
+	for(UINT_64 k = 0; fnWaitChunk(k); ++k)
+	{
+		const size_t b = static_cast<size_t>(k % uBuffers);
+		const bool bOK = SHA1CopyWrite(hDest, pbBuffers + (b * uChunkSize), vLengths[b]);
+		uBytes += vLengths[b];
+
+		std::lock_guard<std::mutex> lock(mtx);
+		if(!bOK) bError = true;
+		++uWritten;
+		cv.notify_all();
+	}
+
+	thReader.join();
+	thHasher.join();
+
+	SHA1CopyClose(hSource, false);
+	if(!SHA1CopyClose(hDest, m_bSync || m_bVerify) || bError)
+	{
+		SHA1CopyRemove(tszDest);
+		return false;
+	}
+
+	sha1.Final();
+	sha1.GetHash(resultOut.pbHash);
+	resultOut.uBytes = uBytes;
+
+	if(m_bVerify)
+	{
+		UINT_8 pbDestHash[20];
+		if(!VerifyDest(tszDest, uBytes, pbDestHash, resultOut.bDirectVerify)) return false;
+
+		resultOut.bMismatch = (memcmp(pbDestHash, resultOut.pbHash, 20) != 0);
+		resultOut.bVerified = !resultOut.bMismatch;
+		return resultOut.bVerified;
+	}
+
+	return true;
+}
+
+bool CSHA1FileCopier::VerifyDest(const TCHAR* tszDest, UINT_64 uExpected,
+	UINT_8* pbHash20Out, bool& bDirectOut)
+{
+	UINT_8* pbBuffer = CSHA1BufferArena::GetThreadArena().Acquire(m_uChunkSize);
+	if(pbBuffer == NULL) return false;
+
+	// Try bypassing the cache first; some file systems do not support it
+	for(int iPass = 0; iPass < 2; ++iPass)
+	{
+		const bool bDirect = (iPass == 0);
+		const SHA1_COPY_FILE hFile = SHA1CopyOpenRead(tszDest, bDirect);
+		if(hFile == SHA1_COPY_NO_FILE) continue;
+
+		CSHA1 sha1;
+		UINT_64 uTotal = 0;
+		bool bOK = true;
+		while(true)
+		{
+			size_t uLen = 0;
+			if(!SHA1CopyReadFull(hFile, pbBuffer, m_uChunkSize, uLen)) { bOK = false; break; }
+
+			sha1.Update(pbBuffer, static_cast<UINT_32>(uLen));
+			uTotal += uLen;
+			if(uLen < m_uChunkSize) break;
+		}
+
+		SHA1CopyClose(hFile, false);
+		if(!bOK) continue;
+
+		// A length mismatch is reported as a digest mismatch
+		if(uTotal != uExpected) sha1.Update(reinterpret_cast<const UINT_8*>("!"), 1);
+
+		sha1.Final();
+		sha1.GetHash(pbHash20Out);
+		bDirectOut = bDirect;
+		return true;
+	}
+
+	return false;
+}
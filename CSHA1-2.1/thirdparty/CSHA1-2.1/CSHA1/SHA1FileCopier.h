@@ -0,0 +1,58 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  File copy that computes the SHA-1 digest of the data while copying it.
+  See SHA1.h for version history.
+
+  The source is read once, in aligned chunks, by a reader thread; a hasher
+  thread and the calling thread (writing the destination) work on the
+  chunks read before, so reading, hashing and writing overlap. With
+  verification enabled, the destination is flushed to disk and read back
+  bypassing the cache (O_DIRECT on Linux, F_NOCACHE on macOS,
+  FILE_FLAG_NO_BUFFERING on Windows) and its digest is compared.
+*/
+
+#ifndef SHA1FILECOPIER_H_A7C2E9F14B3D4E6F8A1B5C7D9E0F2A4B
+#define SHA1FILECOPIER_H_A7C2E9F14B3D4E6F8A1B5C7D9E0F2A4B
+
+#include "SHA1.h"
+
+typedef struct
+{
+	UINT_64 uBytes; // Bytes copied
+	UINT_8 pbHash[20]; // Digest of the source data
+	bool bVerified; // The destination was read back and matches
+	bool bDirectVerify; // The read-back bypassed the cache
+	bool bMismatch; // The destination does not match the source
+} SHA1_COPY_RESULT;
+
+class CSHA1FileCopier
+{
+public:
+	// uChunkSize is rounded up to a multiple of 4096
+	CSHA1FileCopier(UINT_32 uChunkSize = 1024 * 1024, size_t uBuffers = 4);
+
+	void SetVerify(bool bVerify) { m_bVerify = bVerify; }
+
+	// Flush the destination to disk before returning (implied by verify)
+	void SetSync(bool bSync) { m_bSync = bSync; }
+
+	// Copy the source to a new or truncated destination. Fails without
+	// touching the destination if it is the source file itself. A failed
+	// copy removes the destination; a verification mismatch keeps it and
+	// sets bMismatch.
+	bool Copy(const TCHAR* tszSource, const TCHAR* tszDest, SHA1_COPY_RESULT& resultOut);
+
+private:
+	bool VerifyDest(const TCHAR* tszDest, UINT_64 uExpected, UINT_8* pbHash20Out,
+		bool& bDirectOut);
+
+	UINT_32 m_uChunkSize;
+	size_t m_uBuffers;
+	bool m_bVerify;
+	bool m_bSync;
+};
+
+#endif // SHA1FILECOPIER_H_A7C2E9F14B3D4E6F8A1B5C7D9E0F2A4B
@@ -0,0 +1,187 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1FileInfo.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+
+#include <vector>
+
+#define SHA1_FIEMAP_BATCH 128
+#define SHA1_FIEMAP_MAX_EXTENTS 65536
+
+// Extents whose physical location does not identify their data
+#define SHA1_FIEMAP_UNSTABLE (FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DELALLOC | \
+	FIEMAP_EXTENT_ENCODED | FIEMAP_EXTENT_DATA_ENCRYPTED | FIEMAP_EXTENT_NOT_ALIGNED | \
+	FIEMAP_EXTENT_DATA_INLINE | FIEMAP_EXTENT_DATA_TAIL | FIEMAP_EXTENT_UNWRITTEN)
+#endif
+
+#ifdef _WIN32
+
+// FILETIME (100 ns units since 1601) to nanoseconds since 1970
+static INT_64 SHA1FileTimeToNs(INT_64 iFileTime)
+{
+	return ((iFileTime - 116444736000000000LL) * 100);
+}
+
+bool SHA1GetFileId(const TCHAR* tszFileName, SHA1_FILE_ID& idOut)
+{
+	if(tszFileName == NULL) return false;
+
+	HANDLE hFile = CreateFile(tszFileName, FILE_READ_ATTRIBUTES, FILE_SHARE_READ |
+		FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
+	if(hFile == INVALID_HANDLE_VALUE) return false;
+
+	BY_HANDLE_FILE_INFORMATION bhfi;
+	FILE_BASIC_INFO fbi;
+	const bool bResult = ((GetFileInformationByHandle(hFile, &bhfi) != FALSE) &&
+		(GetFileInformationByHandleEx(hFile, FileBasicInfo, &fbi, sizeof(fbi)) != FALSE));
+	CloseHandle(hFile);
+	if(!bResult) return false;
+
+	idOut.uDevice = bhfi.dwVolumeSerialNumber;
+	idOut.uInode = ((static_cast<UINT_64>(bhfi.nFileIndexHigh) << 32) | bhfi.nFileIndexLow);
+	idOut.uSize = ((static_cast<UINT_64>(bhfi.nFileSizeHigh) << 32) | bhfi.nFileSizeLow);
+	idOut.iMTimeNs = SHA1FileTimeToNs(fbi.LastWriteTime.QuadPart);
+	idOut.iCTimeNs = SHA1FileTimeToNs(fbi.ChangeTime.QuadPart);
+	return true;
+}
+
+#else // !_WIN32
+
+void SHA1StatToFileId(const struct stat& st, SHA1_FILE_ID& idOut)
+{
+	idOut.uDevice = static_cast<UINT_64>(st.st_dev);
+	idOut.uInode = static_cast<UINT_64>(st.st_ino);
+	idOut.uSize = static_cast<UINT_64>(st.st_size);
+
+#if defined(__APPLE__)
+	idOut.iMTimeNs = (static_cast<INT_64>(st.st_mtimespec.tv_sec) * 1000000000LL) +
+		st.st_mtimespec.tv_nsec;
+	idOut.iCTimeNs = (static_cast<INT_64>(st.st_ctimespec.tv_sec) * 1000000000LL) +
+		st.st_ctimespec.tv_nsec;
+#else
+	idOut.iMTimeNs = (static_cast<INT_64>(st.st_mtim.tv_sec) * 1000000000LL) +
+		st.st_mtim.tv_nsec;
+	idOut.iCTimeNs = (static_cast<INT_64>(st.st_ctim.tv_sec) * 1000000000LL) +
+		st.st_ctim.tv_nsec;
+#endif
+}
+
+bool SHA1GetFileId(const TCHAR* tszFileName, SHA1_FILE_ID& idOut)
+{
+	if(tszFileName == NULL) return false;
+
+	struct stat st;
+	if(stat(tszFileName, &st) != 0) return false;
+
+	SHA1StatToFileId(st, idOut);
+	return true;
+}
+
+bool SHA1GetFileIdFd(int fd, SHA1_FILE_ID& idOut)
+{
+	struct stat st;
+	if(fstat(fd, &st) != 0) return false;
+
+	SHA1StatToFileId(st, idOut);
+	return true;
+}
+
+#endif // _WIN32
+
+#ifdef __linux__
+static void SHA1UpdatePrint(CSHA1& sha1, UINT_64 uValue)
+{
+	UINT_8 pb[8];
+	for(size_t i = 0; i < 8; ++i) pb[i] = static_cast<UINT_8>((uValue >> (i * 8)) & 0xFF);
+	sha1.Update(pb, 8);
+}
+#endif
+
+bool SHA1GetSharedExtentPrint(const TCHAR* tszFileName, SHA1_FILE_ID& idOut,
+	UINT_8* pbPrint20Out)
+{
+#ifdef __linux__
+	if((tszFileName == NULL) || (pbPrint20Out == NULL)) return false;
+
+	const int fd = open(tszFileName, O_RDONLY | O_CLOEXEC);
+	if(fd < 0) return false;
+
+	bool bResult = (SHA1GetFileIdFd(fd, idOut) && (idOut.uSize != 0));
+
+	// The device and size are part of the print: data beyond the last
+	// extent is a hole, and physical addresses are per file system
+	CSHA1 sha1;
+	SHA1UpdatePrint(sha1, idOut.uDevice);
+	SHA1UpdatePrint(sha1, idOut.uSize);
+
+	std::vector<UINT_64> vMap((sizeof(struct fiemap) + (SHA1_FIEMAP_BATCH *
+		sizeof(struct fiemap_extent)) + 7) / 8);
+	struct fiemap* pMap = reinterpret_cast<struct fiemap*>(&vMap[0]);
+
+	UINT_64 uStart = 0;
+	size_t uExtents = 0;
+	bool bLast = false;
+	while(bResult && !bLast)
+	{
+		memset(pMap, 0, sizeof(struct fiemap));
+		pMap->fm_start = uStart;
+		pMap->fm_length = FIEMAP_MAX_OFFSET - uStart;
+		pMap->fm_flags = FIEMAP_FLAG_SYNC; // Write back delayed allocations first
+		pMap->fm_extent_count = SHA1_FIEMAP_BATCH;
+
+		if(ioctl(fd, FS_IOC_FIEMAP, pMap) != 0) { bResult = false; break; }
+		if(pMap->fm_mapped_extents == 0) break;
+
+		for(UINT_32 i = 0; bResult && (i < pMap->fm_mapped_extents); ++i)
+		{
+			const struct fiemap_extent& fe = pMap->fm_extents[i];
+			if(((fe.fe_flags & FIEMAP_EXTENT_SHARED) == 0) ||
+				((fe.fe_flags & SHA1_FIEMAP_UNSTABLE) != 0))
+				bResult = false;
+
+			SHA1UpdatePrint(sha1, fe.fe_logical);
+			SHA1UpdatePrint(sha1, fe.fe_physical);
+			SHA1UpdatePrint(sha1, fe.fe_length);
+
+			uStart = fe.fe_logical + fe.fe_length;
+			if((fe.fe_flags & FIEMAP_EXTENT_LAST) != 0) bLast = true;
+		}
+
+		uExtents += pMap->fm_mapped_extents;
+		if(uExtents > SHA1_FIEMAP_MAX_EXTENTS) bResult = false;
+	}
+	if(uExtents == 0) bResult = false; // No data at all
+
+	// The map is only meaningful if the file was not changed meanwhile
+	SHA1_FILE_ID idAfter;
+	if(bResult) bResult = (SHA1GetFileIdFd(fd, idAfter) && SHA1IsUnchangedFile(idOut, idAfter));
+	close(fd);
+	if(!bResult) return false;
+
+	sha1.Final();
+	return sha1.GetHash(pbPrint20Out);
+#else
+	(void)tszFileName; (void)idOut; (void)pbPrint20Out;
+	return false;
+#endif
+}
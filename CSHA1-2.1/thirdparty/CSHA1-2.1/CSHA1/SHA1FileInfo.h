@@ -0,0 +1,54 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  File identity and change detection metadata, used by the CSHA1 file
+  utilities. See SHA1.h for version history.
+*/
+
+#ifndef SHA1FILEINFO_H_B1C73F67B83F4361B28BE0DC89AE861F
+#define SHA1FILEINFO_H_B1C73F67B83F4361B28BE0DC89AE861F
+
+#include "SHA1.h"
+
+typedef struct
+{
+	UINT_64 uDevice; // Volume serial number on Windows
+	UINT_64 uInode; // File index on Windows
+	UINT_64 uSize;
+	INT_64 iMTimeNs; // Nanoseconds since the Unix epoch
+	INT_64 iCTimeNs; // Status change time
+} SHA1_FILE_ID;
+
+bool SHA1GetFileId(const TCHAR* tszFileName, SHA1_FILE_ID& idOut);
+
+#ifndef _WIN32
+struct stat;
+
+bool SHA1GetFileIdFd(int fd, SHA1_FILE_ID& idOut);
+void SHA1StatToFileId(const struct stat& st, SHA1_FILE_ID& idOut);
+#endif
+
+// Fingerprint of the physical extent map (Linux FIEMAP) of a file whose
+// data is entirely in extents shared with other files, e.g. reflink
+// copies. Shared extents are copied on write, so files with the same
+// fingerprint have the same contents. Returns false if the map is not
+// available or stable, or if any extent is not shared; idOut is the
+// identity of the file while the map was read.
+bool SHA1GetSharedExtentPrint(const TCHAR* tszFileName, SHA1_FILE_ID& idOut,
+	UINT_8* pbPrint20Out);
+
+inline bool SHA1IsSameFile(const SHA1_FILE_ID& a, const SHA1_FILE_ID& b)
+{
+	return ((a.uDevice == b.uDevice) && (a.uInode == b.uInode));
+}
+
+// Same file and no change of size, modification or status change time
+inline bool SHA1IsUnchangedFile(const SHA1_FILE_ID& a, const SHA1_FILE_ID& b)
+{
+	return (SHA1IsSameFile(a, b) && (a.uSize == b.uSize) &&
+		(a.iMTimeNs == b.iMTimeNs) && (a.iCTimeNs == b.iCTimeNs));
+}
+
+#endif // SHA1FILEINFO_H_B1C73F67B83F4361B28BE0DC89AE861F
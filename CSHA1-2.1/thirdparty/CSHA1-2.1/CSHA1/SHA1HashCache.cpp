@@ -0,0 +1,410 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1HashCache.h"
+#include "SHA1MappedFile.h"
+
+#include <chrono>
+
+#include <errno.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// On-disk format: a 64-byte header followed by 64-byte records, all
+// integers little endian.
+//   Header: "CSHA1HC" 0x00, UINT_32 version, 52 bytes zero
+//   File record: device, inode, size, mtime_ns, ctime_ns (8 bytes each),
+//           digest (20 bytes), FNV-1a checksum of bytes 0-59 (4 bytes)
+//   Extent record: extent map fingerprint (20 bytes), digest (20 bytes),
+//           20 bytes zero, checksum of bytes 0-59 (4 bytes)
+// The record type is given by the checksum basis. Extent records are no
+// longer written (extent entries are only kept for the current run);
+// files containing some are rewritten without them when opened, as are
+// version 1 files.
+#define SHA1_CACHE_RECORD 64
+#define SHA1_CACHE_VERSION 2
+
+#define SHA1_CACHE_FILE_RECORD 0x811C9DC5 // FNV-1a offset basis
+#define SHA1_CACHE_EXTENT_RECORD 0x3A5E1F27
+
+// Files changed less than this before they were hashed are not cached,
+// as a further change might not alter the timestamps
+#define SHA1_CACHE_RACY_NS 2000000000LL
+
+static const UINT_8 g_pbCacheMagic[8] = { 'C', 'S', 'H', 'A', '1', 'H', 'C', 0 };
+
+static void SHA1CachePut64(UINT_8* pb, UINT_64 u)
+{
+	for(size_t i = 0; i < 8; ++i) pb[i] = static_cast<UINT_8>((u >> (i * 8)) & 0xFF);
+}
+
+static UINT_64 SHA1CacheGet64(const UINT_8* pb)
+{
+	UINT_64 u = 0;
+	for(size_t i = 0; i < 8; ++i) u |= (static_cast<UINT_64>(pb[i]) << (i * 8));
+	return u;
+}
+
+static UINT_32 SHA1CacheChecksum(const UINT_8* pb, size_t uLen, UINT_32 uBasis)
+{
+	UINT_32 h = uBasis;
+	for(size_t i = 0; i < uLen; ++i) { h ^= pb[i]; h *= 0x01000193; }
+	return h;
+}
+
+// True if the file has been changed too recently for its timestamps to
+// reveal a further change
+static bool SHA1CacheIsRacy(const SHA1_FILE_ID& id)
+{
+	const INT_64 iNowNs = static_cast<INT_64>(std::chrono::duration_cast<
+		std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+	return (((iNowNs - id.iMTimeNs) < SHA1_CACHE_RACY_NS) ||
+		((iNowNs - id.iCTimeNs) < SHA1_CACHE_RACY_NS));
+}
+
+static void SHA1CacheMakeHeader(UINT_8* pbHeader)
+{
+	memset(pbHeader, 0, SHA1_CACHE_RECORD);
+	memcpy(pbHeader, g_pbCacheMagic, 8);
+	pbHeader[8] = SHA1_CACHE_VERSION;
+}
+
+static bool SHA1CacheFlush(FILE* fp, bool bSync)
+{
+	if(fflush(fp) != 0) return false;
+	if(!bSync) return true;
+
+#ifdef _WIN32
+	return (_commit(_fileno(fp)) == 0);
+#else
+	return (fsync(fileno(fp)) == 0);
+#endif
+}
+
+CSHA1HashCache::CSHA1HashCache() :
+	m_bExtentReuse(false), m_fpLog(NULL), m_bSync(false)
+{
+}
+
+CSHA1HashCache::~CSHA1HashCache()
+{
+	Close();
+}
+
+bool CSHA1HashCache::Open(const TCHAR* tszCacheFile, bool bSync)
+{
+	if(tszCacheFile == NULL) return false;
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+
+	if(m_fpLog != NULL) { fclose(m_fpLog); m_fpLog = NULL; }
+	m_mapEntries.clear();
+	m_mapExtents.clear();
+	m_strFile = tszCacheFile;
+	m_bSync = bSync;
+
+	bool bRewrite = false;
+	if(!Load(bRewrite)) return false;
+	if(bRewrite) return CompactLocked();
+
+	m_fpLog = _tfopen(m_strFile.c_str(), _T("ab"));
+	return (m_fpLog != NULL);
+}
+
+void CSHA1HashCache::Close()
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+
+	if(m_fpLog != NULL) { fclose(m_fpLog); m_fpLog = NULL; }
+	m_mapEntries.clear();
+	m_mapExtents.clear();
+}
+
+// Returns false if the file exists but cannot be read or is not a cache
+// file (foreign data or an unknown version); bRewrite is set if the file
+// is missing or empty, has a torn tail or is a version 1 file
+bool CSHA1HashCache::Load(bool& bRewrite)
+{
+	bRewrite = true;
+
+	FILE* fp = _tfopen(m_strFile.c_str(), _T("rb"));
+	if(fp == NULL) return (errno == ENOENT);
+	fclose(fp);
+
+	CSHA1MappedFile mf;
+	if(!mf.Open(m_strFile.c_str())) return false;
+
+	const UINT_64 uSize = mf.GetSize();
+	const UINT_8* pb = mf.GetData();
+	if(uSize == 0) return true;
+	if(uSize < SHA1_CACHE_RECORD) return false; // Headers are never torn
+
+	UINT_8 pbHeader[SHA1_CACHE_RECORD];
+	SHA1CacheMakeHeader(pbHeader);
+	const bool bCurrent = (memcmp(pb, pbHeader, SHA1_CACHE_RECORD) == 0);
+	bool bExtents = false;
+	if(!bCurrent)
+	{
+		pbHeader[8] = 1; // Version 1 records are loaded and rewritten
+		if(memcmp(pb, pbHeader, SHA1_CACHE_RECORD) != 0) return false;
+	}
+
+	UINT_64 uPos = SHA1_CACHE_RECORD;
+	for( ; (uPos + SHA1_CACHE_RECORD) <= uSize; uPos += SHA1_CACHE_RECORD)
+	{
+		const UINT_8* pbRec = &pb[uPos];
+		const UINT_32 uCheck = static_cast<UINT_32>(SHA1CacheGet64(&pbRec[56]) >> 32);
+		if(bCurrent && (uCheck == SHA1CacheChecksum(pbRec, 60, SHA1_CACHE_EXTENT_RECORD)))
+		{
+			bExtents = true; // The file they were taken from is unknown; drop them
+			continue;
+		}
+		if(uCheck != SHA1CacheChecksum(pbRec, 60, SHA1_CACHE_FILE_RECORD)) break; // Torn append
+
+		CACHE_ENTRY e;
+		e.id.uDevice = SHA1CacheGet64(&pbRec[0]);
+		e.id.uInode = SHA1CacheGet64(&pbRec[8]);
+		e.id.uSize = SHA1CacheGet64(&pbRec[16]);
+		e.id.iMTimeNs = static_cast<INT_64>(SHA1CacheGet64(&pbRec[24]));
+		e.id.iCTimeNs = static_cast<INT_64>(SHA1CacheGet64(&pbRec[32]));
+		memcpy(e.pbHash, &pbRec[40], 20);
+
+		CACHE_KEY k;
+		k.uDevice = e.id.uDevice;
+		k.uInode = e.id.uInode;
+		m_mapEntries[k] = e;
+	}
+
+	bRewrite = (!bCurrent || bExtents || (uPos != uSize));
+	return true;
+}
+
+bool CSHA1HashCache::AppendLocked(const CACHE_ENTRY& e)
+{
+	if(m_fpLog == NULL) return false;
+
+	UINT_8 pbRec[SHA1_CACHE_RECORD];
+	SHA1CachePut64(&pbRec[0], e.id.uDevice);
+	SHA1CachePut64(&pbRec[8], e.id.uInode);
+	SHA1CachePut64(&pbRec[16], e.id.uSize);
+	SHA1CachePut64(&pbRec[24], static_cast<UINT_64>(e.id.iMTimeNs));
+	SHA1CachePut64(&pbRec[32], static_cast<UINT_64>(e.id.iCTimeNs));
+	memcpy(&pbRec[40], e.pbHash, 20);
+
+	return WriteRecordLocked(pbRec, SHA1_CACHE_FILE_RECORD);
+}
+
+bool CSHA1HashCache::WriteRecordLocked(UINT_8* pbRec, UINT_32 uChecksumBasis)
+{
+	const UINT_32 uCheck = SHA1CacheChecksum(pbRec, 60, uChecksumBasis);
+	for(size_t i = 0; i < 4; ++i) pbRec[60 + i] = static_cast<UINT_8>((uCheck >> (i * 8)) & 0xFF);
+
+	// A single record per write, so that a crash tears at most one record
+	if(fwrite(pbRec, 1, SHA1_CACHE_RECORD, m_fpLog) != SHA1_CACHE_RECORD) return false;
+	return SHA1CacheFlush(m_fpLog, m_bSync);
+}
+
+bool CSHA1HashCache::CompactLocked()
+{
+	if(m_fpLog != NULL) { fclose(m_fpLog); m_fpLog = NULL; }
+
+	const std::basic_string<TCHAR> strTemp = m_strFile + _T(".tmp");
+	m_fpLog = _tfopen(strTemp.c_str(), _T("wb"));
+	if(m_fpLog == NULL) return false;
+
+	UINT_8 pbHeader[SHA1_CACHE_RECORD];
+	SHA1CacheMakeHeader(pbHeader);
+	bool bSuccess = (fwrite(pbHeader, 1, SHA1_CACHE_RECORD, m_fpLog) == SHA1_CACHE_RECORD);
+
+	const bool bSync = m_bSync;
+	m_bSync = false;
+	for(std::unordered_map<CACHE_KEY, CACHE_ENTRY, CACHE_KEY_HASH>::const_iterator it =
+		m_mapEntries.begin(); bSuccess && (it != m_mapEntries.end()); ++it)
+		bSuccess = AppendLocked(it->second);
+	m_bSync = bSync;
+
+	// The new file must be durable before it replaces the old one
+	if(bSuccess) bSuccess = SHA1CacheFlush(m_fpLog, true);
+	fclose(m_fpLog);
+	m_fpLog = NULL;
+
+#ifdef _WIN32
+	if(bSuccess) bSuccess = (MoveFileEx(strTemp.c_str(), m_strFile.c_str(),
+		MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE);
+#else
+	if(bSuccess) bSuccess = (rename(strTemp.c_str(), m_strFile.c_str()) == 0);
+#endif
+	if(!bSuccess) return false;
+
+	m_fpLog = _tfopen(m_strFile.c_str(), _T("ab"));
+	return (m_fpLog != NULL);
+}
+
+bool CSHA1HashCache::Compact()
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if(m_strFile.empty()) return false;
+
+	return CompactLocked();
+}
+
+bool CSHA1HashCache::Lookup(const SHA1_FILE_ID& id, UINT_8* pbHash20Out) const
+{
+	if(pbHash20Out == NULL) return false;
+
+	CACHE_KEY k;
+	k.uDevice = id.uDevice;
+	k.uInode = id.uInode;
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+
+	std::unordered_map<CACHE_KEY, CACHE_ENTRY, CACHE_KEY_HASH>::const_iterator it =
+		m_mapEntries.find(k);
+	if(it == m_mapEntries.end()) return false;
+	if(!SHA1IsUnchangedFile(it->second.id, id)) return false;
+
+	memcpy(pbHash20Out, it->second.pbHash, 20);
+	return true;
+}
+
+bool CSHA1HashCache::Store(const SHA1_FILE_ID& id, const UINT_8* pbHash20)
+{
+	if(pbHash20 == NULL) return false;
+
+	CACHE_ENTRY e;
+	e.id = id;
+	memcpy(e.pbHash, pbHash20, 20);
+
+	CACHE_KEY k;
+	k.uDevice = id.uDevice;
+	k.uInode = id.uInode;
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+
+	std::unordered_map<CACHE_KEY, CACHE_ENTRY, CACHE_KEY_HASH>::iterator it =
+		m_mapEntries.find(k);
+	if((it != m_mapEntries.end()) && SHA1IsUnchangedFile(it->second.id, id) &&
+		(memcmp(it->second.pbHash, pbHash20, 20) == 0))
+		return true; // Nothing new
+
+	m_mapEntries[k] = e;
+	return AppendLocked(e);
+}
+
+bool CSHA1HashCache::LookupExtent(const EXTENT_KEY& k, UINT_8* pbHash20Out)
+{
+	EXTENT_ENTRY e;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+
+		std::unordered_map<EXTENT_KEY, EXTENT_ENTRY, EXTENT_KEY_HASH>::const_iterator it =
+			m_mapExtents.find(k);
+		if(it == m_mapExtents.end()) return false;
+		e = it->second;
+	}
+
+	// The extents only hold this data while the file it was read from
+	// keeps them; once that file is changed or deleted, they may have
+	// been freed and reused for other data
+	SHA1_FILE_ID idOrigin;
+	UINT_8 pbOrigin[20];
+	if(SHA1GetFileId(e.strOrigin.c_str(), idOrigin) && SHA1IsUnchangedFile(e.idOrigin, idOrigin) &&
+		Lookup(idOrigin, pbOrigin) && (memcmp(pbOrigin, e.pbHash, 20) == 0))
+	{
+		memcpy(pbHash20Out, e.pbHash, 20);
+		return true;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+
+	std::unordered_map<EXTENT_KEY, EXTENT_ENTRY, EXTENT_KEY_HASH>::iterator it =
+		m_mapExtents.find(k);
+	if((it != m_mapExtents.end()) && SHA1IsUnchangedFile(it->second.idOrigin, e.idOrigin))
+		m_mapExtents.erase(it);
+	return false;
+}
+
+void CSHA1HashCache::StoreExtent(const EXTENT_KEY& k, const UINT_8* pbHash20,
+	const TCHAR* tszOrigin, const SHA1_FILE_ID& idOrigin)
+{
+	EXTENT_ENTRY e;
+	e.k = k;
+	memcpy(e.pbHash, pbHash20, 20);
+	e.idOrigin = idOrigin;
+	e.strOrigin = tszOrigin;
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_mapExtents[k] = e;
+}
+
+size_t CSHA1HashCache::GetEntryCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	return m_mapEntries.size();
+}
+
+size_t CSHA1HashCache::GetExtentEntryCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	return m_mapExtents.size();
+}
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+bool CSHA1HashCache::HashFile(const TCHAR* tszFileName, UINT_8* pbHash20Out,
+	bool* pbFromCache, CSHA1HashControl* pControl)
+{
+	if(pbFromCache != NULL) *pbFromCache = false;
+	if((tszFileName == NULL) || (pbHash20Out == NULL)) return false;
+
+	SHA1_FILE_ID idBefore;
+	if(!SHA1GetFileId(tszFileName, idBefore)) return false;
+
+	if(Lookup(idBefore, pbHash20Out))
+	{
+		if(pbFromCache != NULL) *pbFromCache = true;
+		return true;
+	}
+
+	// A reflink copy of a file hashed before has the same extent map
+	EXTENT_KEY k;
+	SHA1_FILE_ID idExtents;
+	const bool bExtents = (m_bExtentReuse && SHA1GetSharedExtentPrint(tszFileName,
+		idExtents, k.pbPrint) && SHA1IsUnchangedFile(idBefore, idExtents));
+	if(bExtents && LookupExtent(k, pbHash20Out))
+	{
+		if(pbFromCache != NULL) *pbFromCache = true;
+		if(!SHA1CacheIsRacy(idBefore)) Store(idBefore, pbHash20Out);
+		return true;
+	}
+
+	CSHA1 sha1;
+	if(!sha1.HashFile(tszFileName, NULL, pControl)) return false;
+	sha1.Final();
+	sha1.GetHash(pbHash20Out);
+
+	// Only cache the digest if the file has not been changed while it
+	// was read and is not too recent
+	SHA1_FILE_ID idAfter;
+	if(!SHA1GetFileId(tszFileName, idAfter)) return true;
+	if(!SHA1IsUnchangedFile(idBefore, idAfter)) return true;
+
+	// Extent entries are checked against the cache entry of this file,
+	// so they are only kept along with one
+	if(SHA1CacheIsRacy(idAfter)) return true;
+	Store(idAfter, pbHash20Out);
+	if(bExtents) StoreExtent(k, pbHash20Out, tszFileName, idAfter);
+	return true;
+}
+#endif
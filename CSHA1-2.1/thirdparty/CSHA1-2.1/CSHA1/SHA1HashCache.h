@@ -0,0 +1,146 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Persistent cache of file digests. See SHA1.h for version history.
+
+  Entries are keyed by (device, inode) and are only valid as long as
+  size, modification time and status change time are unchanged. The
+  cache file is an append-only table of fixed-size, checksummed records
+  that is memory-mapped when opened; a record torn by a crash is detected
+  and dropped (the file is compacted then). Later records for the same
+  file supersede earlier ones.
+
+  With extent reuse enabled, the cache also maps fingerprints of shared
+  extent maps (SHA1GetSharedExtentPrint) to digests: a reflink copy of a
+  file hashed before in this run gets its digest without its data being
+  read, as long as the file hashed is unchanged and still has a valid
+  entry (so its extents cannot have been freed and reused). Extent
+  entries are not saved in the cache file, as a later run could not tell
+  whether the extents still hold the same data. This assumes that shared
+  extents are never modified in place, which holds for copy-on-write
+  file systems (btrfs, XFS reflink, OCFS2) unless files are written with
+  nodatacow.
+*/
+
+#ifndef SHA1HASHCACHE_H_3114FF4736DD437489ED3C8CB53CAF08
+#define SHA1HASHCACHE_H_3114FF4736DD437489ED3C8CB53CAF08
+
+#include <stdio.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "SHA1.h"
+#include "SHA1FileInfo.h"
+
+class CSHA1HashCache
+{
+public:
+	CSHA1HashCache();
+	~CSHA1HashCache();
+
+	// If bSync is true, every appended record is flushed to disk. A missing
+	// or empty file is created; fails if the file is not a cache file.
+	bool Open(const TCHAR* tszCacheFile, bool bSync = false);
+	void Close();
+
+	// Reuse digests of files with the same shared extent map (Linux only,
+	// off by default); costs one FIEMAP query per uncached file
+	void SetExtentReuse(bool bEnable) { m_bExtentReuse = bEnable; }
+
+	bool Lookup(const SHA1_FILE_ID& id, UINT_8* pbHash20Out) const;
+	bool Store(const SHA1_FILE_ID& id, const UINT_8* pbHash20);
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+	// Returns the digest of the file contents; the file is only read if
+	// the cache has no valid entry for it (pControl: see CSHA1::HashFile)
+	bool HashFile(const TCHAR* tszFileName, UINT_8* pbHash20Out, bool* pbFromCache = NULL,
+		CSHA1HashControl* pControl = NULL);
+#endif
+
+	// Rewrites the cache file with only the current entries
+	bool Compact();
+
+	size_t GetEntryCount() const;
+	size_t GetExtentEntryCount() const;
+
+private:
+	struct CACHE_KEY
+	{
+		UINT_64 uDevice;
+		UINT_64 uInode;
+
+		bool operator==(const CACHE_KEY& k) const
+		{
+			return ((uDevice == k.uDevice) && (uInode == k.uInode));
+		}
+	};
+
+	struct CACHE_KEY_HASH
+	{
+		size_t operator()(const CACHE_KEY& k) const
+		{
+			return static_cast<size_t>((k.uInode * 0x9E3779B97F4A7C15ULL) ^ k.uDevice);
+		}
+	};
+
+	struct CACHE_ENTRY
+	{
+		SHA1_FILE_ID id;
+		UINT_8 pbHash[20];
+	};
+
+	struct EXTENT_KEY
+	{
+		UINT_8 pbPrint[20];
+
+		bool operator==(const EXTENT_KEY& k) const
+		{
+			return (memcmp(pbPrint, k.pbPrint, 20) == 0);
+		}
+	};
+
+	struct EXTENT_KEY_HASH
+	{
+		size_t operator()(const EXTENT_KEY& k) const
+		{
+			size_t h;
+			memcpy(&h, k.pbPrint, sizeof(h)); // Already a digest
+			return h;
+		}
+	};
+
+	struct EXTENT_ENTRY
+	{
+		EXTENT_KEY k;
+		UINT_8 pbHash[20];
+		SHA1_FILE_ID idOrigin; // File the digest was computed from
+		std::basic_string<TCHAR> strOrigin;
+	};
+
+	bool Load(bool& bRewrite);
+	bool CompactLocked();
+	bool AppendLocked(const CACHE_ENTRY& e);
+	bool WriteRecordLocked(UINT_8* pbRec, UINT_32 uChecksumBasis);
+
+	bool LookupExtent(const EXTENT_KEY& k, UINT_8* pbHash20Out);
+	void StoreExtent(const EXTENT_KEY& k, const UINT_8* pbHash20, const TCHAR* tszOrigin,
+		const SHA1_FILE_ID& idOrigin);
+
+	CSHA1HashCache(const CSHA1HashCache&);
+	CSHA1HashCache& operator=(const CSHA1HashCache&);
+
+	std::unordered_map<CACHE_KEY, CACHE_ENTRY, CACHE_KEY_HASH> m_mapEntries;
+	std::unordered_map<EXTENT_KEY, EXTENT_ENTRY, EXTENT_KEY_HASH> m_mapExtents;
+	bool m_bExtentReuse;
+	mutable std::mutex m_mtx;
+
+	std::basic_string<TCHAR> m_strFile;
+	FILE* m_fpLog;
+	bool m_bSync;
+};
+
+#endif // SHA1HASHCACHE_H_3114FF4736DD437489ED3C8CB53CAF08
@@ -0,0 +1,87 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#include "SHA1HashControl.h"
+
+CSHA1HashControl::CSHA1HashControl() :
+	m_pToken(NULL), m_fnProgress(NULL), m_pProgressUserData(NULL),
+	m_uInterval(SHA1_PROGRESS_DEFAULT_INTERVAL), m_uNextReport(0), m_fnCheckpoint(NULL),
+	m_pCheckpointUserData(NULL), m_uCheckpointInterval(SHA1_CHECKPOINT_DEFAULT_INTERVAL),
+	m_uNextCheckpoint(0), m_bDeadline(false),
+	m_uBytesTotal(0), m_uBytesHashed(0), m_bCancelled(false)
+{
+}
+
+void CSHA1HashControl::SetProgressCallback(SHA1_PROGRESS_CALLBACK fnCallback,
+	void* pUserData, UINT_64 uIntervalBytes)
+{
+	m_fnProgress = fnCallback;
+	m_pProgressUserData = pUserData;
+	m_uInterval = ((uIntervalBytes != 0) ? uIntervalBytes : 1);
+}
+
+void CSHA1HashControl::SetCheckpointCallback(SHA1_CHECKPOINT_CALLBACK fnCallback,
+	void* pUserData, UINT_64 uIntervalBytes)
+{
+	m_fnCheckpoint = fnCallback;
+	m_pCheckpointUserData = pUserData;
+	m_uCheckpointInterval = ((uIntervalBytes != 0) ? uIntervalBytes : 1);
+}
+
+void CSHA1HashControl::SetDeadline(const SHA1_CLOCK::time_point& tpDeadline)
+{
+	m_tpDeadline = tpDeadline;
+	m_bDeadline = true;
+}
+
+void CSHA1HashControl::Begin(UINT_64 uBytesTotal, UINT_64 uBytesDone)
+{
+	m_uBytesTotal = uBytesTotal;
+	m_uBytesHashed = uBytesDone;
+	m_uNextReport = uBytesDone + m_uInterval;
+	m_uNextCheckpoint = uBytesDone + m_uCheckpointInterval;
+	m_bCancelled = false;
+}
+
+bool CSHA1HashControl::Continue(UINT_64 uBytesAdded)
+{
+	m_uBytesHashed += uBytesAdded;
+
+	if((m_pToken != NULL) && m_pToken->IsCancelled()) m_bCancelled = true;
+	else if(m_bDeadline && (SHA1_CLOCK::now() >= m_tpDeadline)) m_bCancelled = true;
+	else if((m_fnProgress != NULL) && (m_uBytesHashed >= m_uNextReport))
+	{
+		m_uNextReport = m_uBytesHashed + m_uInterval;
+		if(!m_fnProgress(m_uBytesHashed, m_uBytesTotal, m_pProgressUserData))
+			m_bCancelled = true;
+	}
+
+	return !m_bCancelled;
+}
+
+void CSHA1HashControl::End(UINT_64 uBytesAdded)
+{
+	m_uBytesHashed += uBytesAdded;
+
+	if(m_fnProgress != NULL)
+		m_fnProgress(m_uBytesHashed, m_uBytesTotal, m_pProgressUserData);
+}
+
+bool CSHA1HashControl::IsCheckpointDue() const
+{
+	return ((m_fnCheckpoint != NULL) && (m_uBytesHashed >= m_uNextCheckpoint));
+}
+
+bool CSHA1HashControl::Checkpoint(const UINT_8* pbState)
+{
+	m_uNextCheckpoint = m_uBytesHashed + m_uCheckpointInterval;
+
+	if(!m_fnCheckpoint(pbState, m_uBytesHashed, m_pCheckpointUserData))
+		m_bCancelled = true;
+	return !m_bCancelled;
+}
@@ -0,0 +1,139 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Progress reporting and cancellation for the file hashing functions.
+  See SHA1.h for version history.
+
+  A CSHA1HashControl is passed to a file hashing function, which checks it
+  once per read chunk (never inside the compression loop). Hashing stops
+  when the cancel token is set, the deadline has passed or the progress
+  callback returns false; the function then returns false and
+  WasCancelled reports true.
+
+  The hash object is always left in a consistent state: it has absorbed
+  exactly GetBytesHashed() bytes from the beginning of the file, so a
+  cancelled job can report (or resume from) how far it got.
+
+  With a checkpoint callback, CSHA1::HashFile passes its serialized state
+  (CSHA1::SaveState) to the callback after every interval; an interrupted
+  job continues from the last saved state with CSHA1::ResumeHashFile,
+  losing at most one interval of work.
+
+    CSHA1CancelToken token; // token.Cancel() from any thread
+    CSHA1HashControl ctl;
+    ctl.SetCancelToken(&token);
+    ctl.SetProgressCallback(OnProgress, pUser, 256 * 1024 * 1024);
+    if(!sha1.HashFile(tszPath, NULL, &ctl) && ctl.WasCancelled()) ...
+
+    ctl.SetCheckpointCallback(OnCheckpoint, pUser, 1024 * 1024 * 1024);
+    sha1.ResumeHashFile(tszPath, pbSavedState, SHA1_STATE_SIZE, NULL, &ctl);
+*/
+
+#ifndef SHA1HASHCONTROL_H_9B4E2D7A1C6F4A3E8D5B0F7C2A9E4D61
+#define SHA1HASHCONTROL_H_9B4E2D7A1C6F4A3E8D5B0F7C2A9E4D61
+
+#include <atomic>
+#include <chrono>
+
+#include "SHA1.h"
+
+#ifndef SHA1_PROGRESS_DEFAULT_INTERVAL
+#define SHA1_PROGRESS_DEFAULT_INTERVAL (64 * 1024 * 1024)
+#endif
+
+#ifndef SHA1_CHECKPOINT_DEFAULT_INTERVAL
+#define SHA1_CHECKPOINT_DEFAULT_INTERVAL (1024 * 1024 * 1024)
+#endif
+
+// Return false to cancel; uBytesTotal is 0 if the size is unknown
+typedef bool (*SHA1_PROGRESS_CALLBACK)(UINT_64 uBytesHashed, UINT_64 uBytesTotal,
+	void* pUserData);
+
+// pbState holds SHA1_STATE_SIZE bytes, the state after uOffset bytes of
+// the file; return false to cancel (e.g. if the state cannot be stored)
+typedef bool (*SHA1_CHECKPOINT_CALLBACK)(const UINT_8* pbState, UINT_64 uOffset,
+	void* pUserData);
+
+class CSHA1CancelToken
+{
+public:
+	CSHA1CancelToken() : m_bCancelled(false) { }
+
+	void Cancel() { m_bCancelled.store(true, std::memory_order_relaxed); }
+	void Reset() { m_bCancelled.store(false, std::memory_order_relaxed); }
+	bool IsCancelled() const { return m_bCancelled.load(std::memory_order_relaxed); }
+
+private:
+	CSHA1CancelToken(const CSHA1CancelToken&);
+	CSHA1CancelToken& operator=(const CSHA1CancelToken&);
+
+	std::atomic<bool> m_bCancelled;
+};
+
+class CSHA1HashControl
+{
+public:
+	typedef std::chrono::steady_clock SHA1_CLOCK;
+
+	CSHA1HashControl();
+
+	// The token may be shared by many jobs and must outlive them
+	void SetCancelToken(const CSHA1CancelToken* pToken) { m_pToken = pToken; }
+
+	// The callback is invoked after every uIntervalBytes hashed and once
+	// at the end of the file
+	void SetProgressCallback(SHA1_PROGRESS_CALLBACK fnCallback, void* pUserData,
+		UINT_64 uIntervalBytes = SHA1_PROGRESS_DEFAULT_INTERVAL);
+
+	// Only supported by CSHA1::HashFile and ResumeHashFile (and functions
+	// using them); the state is saved at the first chunk boundary after
+	// every uIntervalBytes. ResumeHashFile continues at the file offset
+	// equal to the saved message length, so HashFile fails with a checkpoint
+	// callback if the hash object already contains other data.
+	void SetCheckpointCallback(SHA1_CHECKPOINT_CALLBACK fnCallback, void* pUserData,
+		UINT_64 uIntervalBytes = SHA1_CHECKPOINT_DEFAULT_INTERVAL);
+	bool HasCheckpointCallback() const { return (m_fnCheckpoint != NULL); }
+
+	void SetDeadline(const SHA1_CLOCK::time_point& tpDeadline);
+	void ClearDeadline() { m_bDeadline = false; }
+
+	// Results of the last job using this control
+	UINT_64 GetBytesHashed() const { return m_uBytesHashed; }
+	bool WasCancelled() const { return m_bCancelled; }
+
+	// Used by the hashing functions: Begin once per job (uBytesDone is the
+	// offset of a resumed job), Continue after each chunk (false if the job
+	// must stop) and End with the length of the last chunk instead of
+	// Continue when the end of the file is reached. If IsCheckpointDue
+	// after Continue, the function passes its state to Checkpoint.
+	void Begin(UINT_64 uBytesTotal, UINT_64 uBytesDone = 0);
+	bool Continue(UINT_64 uBytesAdded);
+	void End(UINT_64 uBytesAdded);
+
+	bool IsCheckpointDue() const;
+	bool Checkpoint(const UINT_8* pbState);
+
+private:
+	const CSHA1CancelToken* m_pToken;
+
+	SHA1_PROGRESS_CALLBACK m_fnProgress;
+	void* m_pProgressUserData;
+	UINT_64 m_uInterval;
+	UINT_64 m_uNextReport;
+
+	SHA1_CHECKPOINT_CALLBACK m_fnCheckpoint;
+	void* m_pCheckpointUserData;
+	UINT_64 m_uCheckpointInterval;
+	UINT_64 m_uNextCheckpoint;
+
+	bool m_bDeadline;
+	SHA1_CLOCK::time_point m_tpDeadline;
+
+	UINT_64 m_uBytesTotal;
+	UINT_64 m_uBytesHashed;
+	bool m_bCancelled;
+};
+
+#endif // SHA1HASHCONTROL_H_9B4E2D7A1C6F4A3E8D5B0F7C2A9E4D61
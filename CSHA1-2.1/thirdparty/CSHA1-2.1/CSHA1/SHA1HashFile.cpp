@@ -0,0 +1,311 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+// File hashing of CSHA1 with buffer arena, hash control (progress,
+// cancellation, checkpoints), sparse file support, statistics and
+// tracepoints. Requires C++11; SHA1.cpp contains a plain HashFile otherwise.
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1.h"
+
+#if defined(SHA1_UTILITY_FUNCTIONS) && defined(SHA1_HAS_CPP11)
+
+#include "SHA1BufferArena.h"
+#include "SHA1HashControl.h"
+#include "SHA1Probes.h"
+#include "SHA1Stats.h"
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+#define SHA1_FSEEK64 _fseeki64
+#else
+#define SHA1_FSEEK64 fseeko
+#endif
+
+#define SHA1_MAX_FILE_BUFFER (32 * 20 * 820)
+
+// Files smaller than this are read into a stack buffer
+#define SHA1_SMALL_FILE_BUFFER 4096
+
+// Holes of sparse files are hashed without reading them (SEEK_DATA and
+// SEEK_HOLE); smaller files are always read
+#if defined(SEEK_DATA) && defined(SEEK_HOLE) && !defined(_WIN32) && \
+	!defined(SHA1_NO_SPARSE_FILES)
+#define SHA1_SPARSE_FILES
+#define SHA1_SPARSE_MIN_SIZE (1024 * 1024)
+#endif
+
+// Size of a regular file; false for other files (pipes, devices)
+static bool SHA1GetOpenFileSize(FILE* fp, UINT_64& uSizeOut)
+{
+#ifdef _WIN32
+	struct _stat64 st;
+	if(_fstat64(_fileno(fp), &st) != 0) return false;
+	if((st.st_mode & _S_IFREG) == 0) return false;
+#else
+	struct stat st;
+	if(fstat(fileno(fp), &st) != 0) return false;
+	if(!S_ISREG(st.st_mode)) return false;
+#endif
+
+	uSizeOut = static_cast<UINT_64>(st.st_size);
+	return true;
+}
+
+#ifdef SHA1_SPARSE_FILES
+// Source of the bytes in holes; never written, so all pages map the
+// system's zero page
+static UINT_8 g_pbSHA1Zeroes[SHA1_MAX_FILE_BUFFER];
+
+typedef struct
+{
+	int fd;
+	UINT_64 uPos;
+	UINT_64 uEnd; // File size when opened, lowered if it shrinks
+	UINT_64 uData; // Next allocated extent [uData, uHole)
+	UINT_64 uHole;
+} SHA1_SPARSE_READER;
+
+// Returns the next chunk at r.uPos (at most uBufferSize bytes); chunks in
+// holes point into the zero buffer and do not cause any I/O
+static bool SHA1ReadSparse(SHA1_SPARSE_READER& r, UINT_8* pbBuffer, size_t uBufferSize,
+	const UINT_8*& pbChunk, size_t& uChunk)
+{
+	if(r.uPos >= r.uHole)
+	{
+		const off_t oData = lseek(r.fd, static_cast<off_t>(r.uPos), SEEK_DATA);
+		if(oData >= 0)
+		{
+			const off_t oHole = lseek(r.fd, oData, SEEK_HOLE);
+			if(oHole < 0) return false;
+			r.uData = static_cast<UINT_64>(oData);
+			r.uHole = static_cast<UINT_64>(oHole);
+		}
+		else if(errno == ENXIO) // Hole up to the end, or truncated while hashing
+		{
+			struct stat st;
+			if(fstat(r.fd, &st) != 0) return false;
+			const UINT_64 uSize = static_cast<UINT_64>(st.st_size);
+			if(uSize < r.uEnd) r.uEnd = ((uSize > r.uPos) ? uSize : r.uPos);
+			r.uData = r.uHole = r.uEnd;
+		}
+		else return false;
+
+		if(r.uData > r.uEnd) r.uData = r.uEnd;
+		if(r.uHole > r.uEnd) r.uHole = r.uEnd;
+	}
+
+	if(r.uPos < r.uData)
+	{
+		pbChunk = g_pbSHA1Zeroes;
+		uChunk = (((r.uData - r.uPos) < uBufferSize) ? static_cast<size_t>(r.uData -
+			r.uPos) : uBufferSize);
+	}
+	else
+	{
+		const size_t uWant = (((r.uHole - r.uPos) < uBufferSize) ? static_cast<size_t>(
+			r.uHole - r.uPos) : uBufferSize);
+		ssize_t iRead;
+		do { iRead = pread(r.fd, pbBuffer, uWant, static_cast<off_t>(r.uPos)); }
+		while((iRead < 0) && (errno == EINTR));
+		if(iRead < 0) return false;
+
+		pbChunk = pbBuffer;
+		uChunk = static_cast<size_t>(iRead);
+
+		// Truncated while hashing; the stream continues at the new end and
+		// detects the end of the file like for non-sparse files
+		if(uChunk < uWant) r.uEnd = r.uPos + uChunk;
+	}
+
+	r.uPos += uChunk;
+	return true;
+}
+#endif
+
+bool CSHA1::HashFile(const TCHAR* tszFileName, CSHA1BufferArena* pArena,
+	CSHA1HashControl* pControl)
+{
+	return HashFileFrom(tszFileName, 0, pArena, pControl);
+}
+
+bool CSHA1::ResumeHashFile(const TCHAR* tszFileName, const UINT_8* pbState,
+	size_t uStateSize, CSHA1BufferArena* pArena, CSHA1HashControl* pControl)
+{
+	if(!LoadState(pbState, uStateSize)) return false;
+
+	return HashFileFrom(tszFileName, GetByteCount(), pArena, pControl);
+}
+
+bool CSHA1::HashFileFrom(const TCHAR* tszFileName, UINT_64 uOffset, CSHA1BufferArena* pArena,
+	CSHA1HashControl* pControl)
+{
+	if(tszFileName == NULL) return false;
+
+	// A checkpoint only records the message length, which ResumeHashFile
+	// uses as the file offset; refuse if data was hashed in before the file
+	if((pControl != NULL) && pControl->HasCheckpointCallback() &&
+		(GetByteCount() != uOffset)) return false;
+
+	FILE* fpIn = _tfopen(tszFileName, _T("rb"));
+	if(fpIn == NULL) return false;
+
+	// Read directly into our buffer; this also avoids the stdio buffer
+	// allocation for each file
+	setvbuf(fpIn, NULL, _IONBF, 0);
+
+	// Read the whole file at once if it is smaller than the maximum buffer
+	// (one byte more, so that the end of the file is detected by that read)
+	size_t uBufferSize = SHA1_MAX_FILE_BUFFER;
+	UINT_64 uFileSize = 0;
+	if(!SHA1GetOpenFileSize(fpIn, uFileSize)) uFileSize = 0;
+	else if(uFileSize < uOffset) { fclose(fpIn); return false; } // Truncated since the checkpoint
+	else if((uFileSize - uOffset) < SHA1_MAX_FILE_BUFFER)
+		uBufferSize = static_cast<size_t>(uFileSize - uOffset) + 1;
+
+	bool bSeek = (uOffset != 0);
+#ifdef SHA1_SPARSE_FILES
+	// Only files with a hole take the sparse path; the probe moves the
+	// file offset, so the stream is repositioned below
+	SHA1_SPARSE_READER sparse = { -1, 0, 0, 0, 0 };
+	bool bSparse = false;
+	if(uFileSize >= (uOffset + SHA1_SPARSE_MIN_SIZE))
+	{
+		sparse.fd = fileno(fpIn);
+		const off_t oHole = lseek(sparse.fd, static_cast<off_t>(uOffset), SEEK_HOLE);
+		bSparse = ((oHole >= 0) && (static_cast<UINT_64>(oHole) < uFileSize));
+		sparse.uPos = sparse.uData = sparse.uHole = uOffset;
+		sparse.uEnd = uFileSize;
+		bSeek = true;
+	}
+#endif
+
+	if(bSeek && (SHA1_FSEEK64(fpIn, static_cast<INT_64>(uOffset), SEEK_SET) != 0))
+	{
+		fclose(fpIn);
+		return false;
+	}
+
+	UINT_8 pbSmall[SHA1_SMALL_FILE_BUFFER];
+	UINT_8* pbData = pbSmall;
+	if(uBufferSize > SHA1_SMALL_FILE_BUFFER)
+	{
+		if(pArena == NULL) pArena = &CSHA1BufferArena::GetThreadArena();
+		pbData = pArena->Acquire(uBufferSize);
+		if(pbData == NULL) { fclose(fpIn); return false; }
+	}
+	else uBufferSize = SHA1_SMALL_FILE_BUFFER;
+
+	if(pControl != NULL) pControl->Begin(uFileSize, uOffset);
+	if(SHA1_PROBE_ENABLED(file_open)) SHA1_PROBE2(file_open, tszFileName, uFileSize);
+
+	// The clock is only read if statistics are enabled or a tracer is
+	// attached to one of the timed probes
+	const bool bStats = SHA1StatsEnabled();
+	const bool bTimed = (bStats || SHA1_PROBE_ENABLED(chunk_read) ||
+		SHA1_PROBE_ENABLED(chunk_hash) || SHA1_PROBE_ENABLED(file_close));
+	SHA1_STATS_CLOCK::time_point tpStart, tpRead, tpHashed;
+	UINT_64 uBytes = 0, uReadNs = 0, uHashNs = 0;
+	if(bTimed) tpStart = tpHashed = SHA1_STATS_CLOCK::now();
+
+	bool bSuccess = true;
+	while(true)
+	{
+		const UINT_8* pbChunk = pbData;
+		size_t uRead;
+		bool bLast;
+#ifdef SHA1_SPARSE_FILES
+		// Bytes appended after opening the file are read by the stream
+		if(bSparse && (sparse.uPos >= sparse.uEnd))
+		{
+			bSparse = false;
+			if(SHA1_FSEEK64(fpIn, static_cast<INT_64>(sparse.uEnd), SEEK_SET) != 0)
+			{
+				bSuccess = false;
+				break;
+			}
+		}
+
+		if(bSparse)
+		{
+			if(!SHA1ReadSparse(sparse, pbData, uBufferSize, pbChunk, uRead))
+			{
+				bSuccess = false;
+				break;
+			}
+			bLast = false;
+		}
+		else
+#endif
+		{
+			uRead = fread(pbData, 1, uBufferSize, fpIn);
+			bLast = (uRead < uBufferSize);
+		}
+		if(bTimed) tpRead = SHA1_STATS_CLOCK::now();
+
+		if(uRead > 0)
+			Update(pbChunk, static_cast<UINT_32>(uRead));
+
+		if(bTimed)
+		{
+			const SHA1_STATS_CLOCK::time_point tpLast = tpHashed;
+			tpHashed = SHA1_STATS_CLOCK::now();
+			const UINT_64 uChunkReadNs = SHA1StatsNs(tpLast, tpRead);
+			const UINT_64 uChunkHashNs = SHA1StatsNs(tpRead, tpHashed);
+			uReadNs += uChunkReadNs;
+			uHashNs += uChunkHashNs;
+			uBytes += uRead;
+
+			SHA1_PROBE2(chunk_read, uRead, uChunkReadNs);
+			SHA1_PROBE2(chunk_hash, uRead, uChunkHashNs);
+		}
+
+		if(bLast)
+		{
+			if(feof(fpIn) == 0) bSuccess = false;
+			if(pControl != NULL) pControl->End(uRead);
+			break;
+		}
+
+		if((pControl != NULL) && !pControl->Continue(uRead))
+		{
+			bSuccess = false;
+			break;
+		}
+
+		if((pControl != NULL) && pControl->IsCheckpointDue())
+		{
+			UINT_8 pbState[SHA1_STATE_SIZE];
+			SaveState(pbState, sizeof(pbState));
+			if(!pControl->Checkpoint(pbState))
+			{
+				bSuccess = false;
+				break;
+			}
+		}
+	}
+
+	fclose(fpIn);
+
+	if(bTimed)
+	{
+		const UINT_64 uTotalNs = SHA1StatsNs(tpStart, SHA1_STATS_CLOCK::now());
+		if(bStats && bSuccess) SHA1StatsAddFile(uBytes, uTotalNs, uReadNs, uHashNs);
+		SHA1_PROBE4(file_close, tszFileName, uBytes, uTotalNs, (bSuccess ? 1 : 0));
+	}
+	return bSuccess;
+}
+
+#endif // SHA1_UTILITY_FUNCTIONS && SHA1_HAS_CPP11
@@ -0,0 +1,154 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#include "SHA1JobManager.h"
+#include "SHA1ThreadPool.h"
+
+#include <memory>
+
+CSHA1JobManager::CSHA1JobManager(size_t uLanes, UINT_32 uFlushMicroseconds,
+	size_t uThreads) :
+	m_uLanes((uLanes != 0) ? uLanes : 1),
+	m_durFlush(std::chrono::microseconds(uFlushMicroseconds)),
+	m_uPendingBytes(0), m_bStop(false)
+{
+	m_vPending.reserve(m_uLanes);
+	m_pPool = new CSHA1ThreadPool(uThreads);
+	m_thFlusher = std::thread(&CSHA1JobManager::FlusherMain, this);
+}
+
+CSHA1JobManager::~CSHA1JobManager()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_bStop = true;
+		DispatchLocked();
+	}
+	m_cvPending.notify_one();
+	m_thFlusher.join();
+
+	delete m_pPool; // Runs the remaining batches
+}
+
+void CSHA1JobManager::Submit(const void* pData, size_t uLen,
+	SHA1_JOB_CALLBACK fnCallback, void* pUserData)
+{
+	SHA1_JOB job;
+	job.pbData = static_cast<const UINT_8*>(pData);
+	job.uLen = uLen;
+	job.fnDone = [fnCallback, pUserData](const UINT_8* pbHash)
+		{ if(fnCallback != NULL) fnCallback(pbHash, pUserData); };
+	Enqueue(job);
+}
+
+std::future<CSHA1Digest> CSHA1JobManager::Submit(const void* pData, size_t uLen)
+{
+	std::shared_ptr<std::promise<CSHA1Digest> > spPromise =
+		std::make_shared<std::promise<CSHA1Digest> >();
+	std::future<CSHA1Digest> f = spPromise->get_future();
+
+	SHA1_JOB job;
+	job.pbData = static_cast<const UINT_8*>(pData);
+	job.uLen = uLen;
+	job.fnDone = [spPromise](const UINT_8* pbHash)
+		{ spPromise->set_value(CSHA1Digest(pbHash)); };
+	Enqueue(job);
+
+	return f;
+}
+
+void CSHA1JobManager::Enqueue(SHA1_JOB& job)
+{
+	bool bNotify = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+
+		if(m_vPending.empty())
+		{
+			m_tpOldest = SHA1_CLOCK::now();
+			bNotify = true;
+		}
+
+		m_vPending.push_back(SHA1_JOB());
+		m_vPending.back().pbData = job.pbData;
+		m_vPending.back().uLen = job.uLen;
+		m_vPending.back().fnDone.swap(job.fnDone);
+		m_uPendingBytes += job.uLen;
+
+		if((m_vPending.size() >= m_uLanes) || (m_uPendingBytes >= SHA1_JOB_BATCH_BYTES))
+		{
+			DispatchLocked();
+			bNotify = false;
+		}
+	}
+
+	// Arm the deadline of the new partial batch
+	if(bNotify) m_cvPending.notify_one();
+}
+
+void CSHA1JobManager::Flush()
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	DispatchLocked();
+}
+
+void CSHA1JobManager::Wait()
+{
+	Flush();
+	m_pPool->Wait();
+}
+
+void CSHA1JobManager::DispatchLocked()
+{
+	if(m_vPending.empty()) return;
+
+	std::shared_ptr<std::vector<SHA1_JOB> > spBatch =
+		std::make_shared<std::vector<SHA1_JOB> >();
+	spBatch->swap(m_vPending);
+	m_vPending.reserve(m_uLanes);
+	m_uPendingBytes = 0;
+
+	m_pPool->Submit([spBatch]()
+	{
+		UINT_8 pbHash[20];
+		for(size_t i = 0; i < spBatch->size(); ++i)
+		{
+			const SHA1_JOB& job = (*spBatch)[i];
+
+			SHA1_IOVEC v;
+			v.iov_base = const_cast<UINT_8*>(job.pbData);
+			v.iov_len = job.uLen;
+
+			CSHA1 sha1;
+			sha1.UpdateV(&v, 1);
+			sha1.Final();
+			sha1.GetHash(pbHash);
+
+			job.fnDone(pbHash);
+		}
+	});
+}
+
+void CSHA1JobManager::FlusherMain()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	while(!m_bStop)
+	{
+		if(m_vPending.empty())
+		{
+			m_cvPending.wait(lock);
+			continue;
+		}
+
+		// The batch may be dispatched and replaced while waiting
+		const SHA1_CLOCK::time_point tpDeadline = m_tpOldest + m_durFlush;
+		if(SHA1_CLOCK::now() >= tpDeadline) DispatchLocked();
+		else m_cvPending.wait_until(lock, tpDeadline);
+	}
+}
@@ -0,0 +1,95 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Asynchronous hashing of many independent messages. See SHA1.h for
+  version history.
+
+  Submitted jobs are collected into batches of up to uLanes jobs. A batch
+  is dispatched to a worker as soon as it is full (or holds at least
+  SHA1_JOB_BATCH_BYTES), otherwise when its oldest job has been waiting
+  for the flush deadline. Workers hash the jobs of a batch one after
+  another, so under load the synchronization cost is paid once per batch;
+  under light load a job waits at most the deadline before it is hashed.
+  Jobs complete out of order.
+
+  The data of a job must stay valid until its completion has been
+  reported (callback invoked or future ready).
+*/
+
+#ifndef SHA1JOBMANAGER_H_7D2E0B9C4A6F4F1B8E3D5C7A9B1E2F40
+#define SHA1JOBMANAGER_H_7D2E0B9C4A6F4F1B8E3D5C7A9B1E2F40
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SHA1.h"
+#include "SHA1Digest.h"
+
+class CSHA1ThreadPool;
+
+// A batch holding at least this many bytes is dispatched immediately
+#ifndef SHA1_JOB_BATCH_BYTES
+#define SHA1_JOB_BATCH_BYTES (256 * 1024)
+#endif
+
+// Invoked on a worker thread
+typedef void (*SHA1_JOB_CALLBACK)(const UINT_8* pbHash20, void* pUserData);
+
+class CSHA1JobManager
+{
+public:
+	// If uThreads is 0, one thread per hardware thread is used
+	CSHA1JobManager(size_t uLanes = 8, UINT_32 uFlushMicroseconds = 100,
+		size_t uThreads = 0);
+	~CSHA1JobManager(); // Completes all submitted jobs
+
+	void Submit(const void* pData, size_t uLen, SHA1_JOB_CALLBACK fnCallback,
+		void* pUserData);
+	std::future<CSHA1Digest> Submit(const void* pData, size_t uLen);
+
+	// Dispatch the current partial batch without waiting for the deadline
+	void Flush();
+
+	// Wait until all jobs submitted so far have completed
+	void Wait();
+
+private:
+	typedef struct
+	{
+		const UINT_8* pbData;
+		size_t uLen;
+		std::function<void(const UINT_8*)> fnDone;
+	} SHA1_JOB;
+
+	typedef std::chrono::steady_clock SHA1_CLOCK;
+
+	void Enqueue(SHA1_JOB& job);
+	void DispatchLocked();
+	void FlusherMain();
+
+	CSHA1JobManager(const CSHA1JobManager&);
+	CSHA1JobManager& operator=(const CSHA1JobManager&);
+
+	size_t m_uLanes;
+	SHA1_CLOCK::duration m_durFlush;
+
+	std::vector<SHA1_JOB> m_vPending;
+	size_t m_uPendingBytes;
+	SHA1_CLOCK::time_point m_tpOldest;
+
+	std::mutex m_mtx;
+	std::condition_variable m_cvPending;
+	bool m_bStop;
+	std::thread m_thFlusher;
+
+	CSHA1ThreadPool* m_pPool;
+};
+
+#endif // SHA1JOBMANAGER_H_7D2E0B9C4A6F4F1B8E3D5C7A9B1E2F40
@@ -0,0 +1,422 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1KernelHash.h"
+#include "SHA1BufferArena.h"
+#include "SHA1FileInfo.h"
+#include "SHA1HashControl.h"
+#include "SHA1Probes.h"
+#include "SHA1Stats.h"
+
+#include <chrono>
+#include <vector>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <linux/if_alg.h>
+#ifndef AF_ALG
+#define AF_ALG 38
+#endif
+#define SHA1_KERNEL_ALG
+#endif
+
+// Bytes moved per splice call (the kernel accepts at most 16 pages per
+// hash update from a pipe)
+#define SHA1_KERNEL_SPLICE (64 * 1024)
+
+#define SHA1_KERNEL_READ_BUFFER (1024 * 1024)
+
+#ifdef SHA1_KERNEL_ALG
+static int SHA1KernelBind()
+{
+	const int fd = socket(AF_ALG, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if(fd < 0) return -1;
+
+	sockaddr_alg sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.salg_family = AF_ALG;
+	memcpy(sa.salg_type, "hash", 5);
+	memcpy(sa.salg_name, "sha1", 5);
+
+	if(bind(fd, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa)) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+#endif
+
+CSHA1KernelHash::CSHA1KernelHash() :
+	m_fdAlg(-1), m_fdOp(-1), m_bError(false), m_uBytes(0)
+{
+	memset(m_digest, 0, 20);
+	OpenKernel();
+}
+
+CSHA1KernelHash::~CSHA1KernelHash()
+{
+	CloseKernel();
+}
+
+bool CSHA1KernelHash::OpenKernel()
+{
+#ifdef SHA1_KERNEL_ALG
+	if(m_fdAlg < 0) m_fdAlg = SHA1KernelBind();
+	if(m_fdAlg < 0) return false;
+
+	m_fdOp = accept4(m_fdAlg, NULL, NULL, SOCK_CLOEXEC);
+	if(m_fdOp >= 0) return true;
+#endif
+
+	CloseKernel();
+	return false;
+}
+
+void CSHA1KernelHash::CloseKernel()
+{
+#ifdef SHA1_KERNEL_ALG
+	if(m_fdOp >= 0) close(m_fdOp);
+	if(m_fdAlg >= 0) close(m_fdAlg);
+#endif
+	m_fdOp = -1;
+	m_fdAlg = -1;
+}
+
+void CSHA1KernelHash::Reset()
+{
+	m_bError = false;
+	m_uBytes = 0;
+	m_sha1.Reset();
+	memset(m_digest, 0, 20);
+
+#ifdef SHA1_KERNEL_ALG
+	// A new operation socket discards any pending data
+	if(m_fdOp >= 0)
+	{
+		close(m_fdOp);
+		m_fdOp = -1;
+		OpenKernel();
+	}
+#endif
+}
+
+bool CSHA1KernelHash::SendKernel(const UINT_8* pbData, size_t uLen)
+{
+#ifdef SHA1_KERNEL_ALG
+	while(uLen != 0)
+	{
+		const ssize_t iSent = send(m_fdOp, pbData, uLen, MSG_MORE);
+		if(iSent < 0)
+		{
+			if(errno == EINTR) continue;
+			return false;
+		}
+
+		pbData += iSent;
+		uLen -= static_cast<size_t>(iSent);
+		m_uBytes += static_cast<UINT_64>(iSent);
+	}
+
+	return true;
+#else
+	(void)pbData; (void)uLen;
+	return false;
+#endif
+}
+
+void CSHA1KernelHash::Update(const UINT_8* pbData, UINT_32 uLen)
+{
+	if((pbData == NULL) || (uLen == 0)) return;
+
+	if(m_fdOp < 0) m_sha1.Update(pbData, uLen);
+	else if(!SendKernel(pbData, uLen)) m_bError = true;
+}
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+bool CSHA1KernelHash::HashFile(const TCHAR* tszFileName, CSHA1HashControl* pControl)
+{
+	if(tszFileName == NULL) return false;
+	if(m_fdOp < 0)
+	{
+		SHA1_PROBE3(kernel_dispatch, SHA1_STATS_KERNEL_SCALAR, 0, 0);
+		return m_sha1.HashFile(tszFileName, NULL, pControl);
+	}
+
+#ifdef SHA1_KERNEL_ALG
+	const int fdFile = open(tszFileName, O_RDONLY | O_CLOEXEC);
+	if(fdFile < 0) return false;
+
+	UINT_64 uFileSize = 0;
+	if((pControl != NULL) || SHA1_PROBE_ENABLED(kernel_dispatch))
+	{
+		struct stat st;
+		if((fstat(fdFile, &st) == 0) && S_ISREG(st.st_mode))
+			uFileSize = static_cast<UINT_64>(st.st_size);
+	}
+	if(pControl != NULL) pControl->Begin(uFileSize);
+
+	int pfdPipe[2] = { -1, -1 };
+	bool bSplice = (pipe2(pfdPipe, O_CLOEXEC) == 0);
+	bool bSuccess = true;
+	if(bSplice) SHA1_PROBE3(kernel_dispatch, SHA1_STATS_KERNEL_AF_ALG, 1, uFileSize);
+
+	// File -> pipe -> socket, without copying the pages to user space
+	while(bSplice)
+	{
+		const ssize_t iIn = splice(fdFile, NULL, pfdPipe[1], NULL, SHA1_KERNEL_SPLICE,
+			SPLICE_F_MORE | SPLICE_F_MOVE);
+		if(iIn == 0)
+		{
+			if(pControl != NULL) pControl->End(0);
+			break;
+		}
+		if(iIn < 0)
+		{
+			if(errno == EINTR) continue;
+
+			// File systems without splice support are read below
+			if((errno != EINVAL) || (lseek(fdFile, 0, SEEK_CUR) != 0)) bSuccess = false;
+			bSplice = false;
+			break;
+		}
+
+		size_t uPending = static_cast<size_t>(iIn);
+		while(uPending != 0)
+		{
+			const ssize_t iOut = splice(pfdPipe[0], NULL, m_fdOp, NULL, uPending,
+				SPLICE_F_MORE | SPLICE_F_MOVE);
+			if(iOut < 0)
+			{
+				if(errno == EINTR) continue;
+				break;
+			}
+			uPending -= static_cast<size_t>(iOut);
+			m_uBytes += static_cast<UINT_64>(iOut);
+		}
+
+		if(uPending != 0)
+		{
+			m_bError = true;
+			bSuccess = false;
+			break;
+		}
+
+		if((pControl != NULL) && !pControl->Continue(static_cast<UINT_64>(iIn)))
+		{
+			bSuccess = false;
+			break;
+		}
+	}
+
+	if(pfdPipe[0] >= 0)
+	{
+		close(pfdPipe[0]);
+		close(pfdPipe[1]);
+	}
+
+	if(!bSplice && bSuccess)
+	{
+		SHA1_PROBE3(kernel_dispatch, SHA1_STATS_KERNEL_AF_ALG, 2, uFileSize);
+
+		UINT_8* pbBuffer = CSHA1BufferArena::GetThreadArena().Acquire(SHA1_KERNEL_READ_BUFFER);
+		while(pbBuffer != NULL)
+		{
+			const ssize_t iRead = read(fdFile, pbBuffer, SHA1_KERNEL_READ_BUFFER);
+			if(iRead == 0)
+			{
+				if(pControl != NULL) pControl->End(0);
+				break;
+			}
+			if(iRead < 0)
+			{
+				if(errno == EINTR) continue;
+				bSuccess = false;
+				break;
+			}
+
+			if(!SendKernel(pbBuffer, static_cast<size_t>(iRead)))
+			{
+				m_bError = true;
+				bSuccess = false;
+				break;
+			}
+
+			if((pControl != NULL) && !pControl->Continue(static_cast<UINT_64>(iRead)))
+			{
+				bSuccess = false;
+				break;
+			}
+		}
+	}
+
+	close(fdFile);
+	return bSuccess;
+#else
+	return false;
+#endif
+}
+#endif
+
+void CSHA1KernelHash::Final()
+{
+	if(m_fdOp < 0)
+	{
+		m_sha1.Final();
+		m_sha1.GetHash(m_digest);
+		return;
+	}
+
+#ifdef SHA1_KERNEL_ALG
+	// A send without MSG_MORE finalizes the digest
+	if(!m_bError && ((send(m_fdOp, NULL, 0, 0) != 0) ||
+		(read(m_fdOp, m_digest, 20) != 20)))
+		m_bError = true;
+
+	if(SHA1StatsEnabled() && !m_bError) SHA1StatsAddMessage(SHA1_STATS_KERNEL_AF_ALG, m_uBytes);
+	SHA1_PROBE2(final, m_uBytes, SHA1_STATS_KERNEL_AF_ALG);
+#endif
+}
+
+bool CSHA1KernelHash::GetHash(UINT_8* pbDest20) const
+{
+	if((pbDest20 == NULL) || m_bError) return false;
+	memcpy(pbDest20, m_digest, 20);
+	return true;
+}
+
+bool CSHA1KernelHash::IsAvailable()
+{
+#ifdef SHA1_KERNEL_ALG
+	static const bool bAvailable = []() -> bool
+	{
+		const int fd = SHA1KernelBind();
+		if(fd < 0) return false;
+		close(fd);
+		return true;
+	}();
+	return bAvailable;
+#else
+	return false;
+#endif
+}
+
+std::string CSHA1KernelHash::GetDriverName()
+{
+	std::string strBest;
+
+#ifdef __linux__
+	FILE* fp = fopen("/proc/crypto", "r");
+	if(fp == NULL) return strBest;
+
+	// Entries are separated by empty lines; the driver with the highest
+	// priority is used for "sha1"
+	std::string strName, strDriver;
+	long lPriority = -1, lBest = -1;
+	char szLine[256];
+	bool bEnd = false;
+	while(!bEnd)
+	{
+		bEnd = (fgets(szLine, sizeof(szLine), fp) == NULL);
+
+		std::string strLine = (bEnd ? std::string() : std::string(szLine));
+		const size_t uColon = strLine.find(':');
+		if(uColon == std::string::npos)
+		{
+			if((strName == "sha1") && (lPriority > lBest))
+			{
+				lBest = lPriority;
+				strBest = strDriver;
+			}
+
+			strName.clear();
+			strDriver.clear();
+			lPriority = -1;
+			continue;
+		}
+
+		std::string strKey = strLine.substr(0, uColon);
+		std::string strValue = strLine.substr(uColon + 1);
+		strKey.erase(strKey.find_last_not_of(" \t") + 1);
+		strValue.erase(0, strValue.find_first_not_of(" \t"));
+		strValue.erase(strValue.find_last_not_of(" \t\r\n") + 1);
+
+		if(strKey == "name") strName = strValue;
+		else if(strKey == "driver") strDriver = strValue;
+		else if(strKey == "priority") lPriority = strtol(strValue.c_str(), NULL, 10);
+	}
+
+	fclose(fp);
+#endif
+
+	return strBest;
+}
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+bool SHA1BenchmarkBackends(const TCHAR* tszFileName, size_t uRounds,
+	SHA1_BACKEND_BENCHMARK& resultOut)
+{
+	resultOut.dUserMBps = resultOut.dKernelUpdateMBps = resultOut.dKernelSpliceMBps = 0.0;
+	resultOut.strDriver = CSHA1KernelHash::GetDriverName();
+
+	SHA1_FILE_ID id;
+	if((tszFileName == NULL) || (uRounds == 0) || !SHA1GetFileId(tszFileName, id))
+		return false;
+
+	const double dMB = (static_cast<double>(id.uSize) * static_cast<double>(uRounds)) /
+		(1024.0 * 1024.0);
+	typedef std::chrono::steady_clock SHA1_CLOCK;
+
+	SHA1_CLOCK::time_point tpStart = SHA1_CLOCK::now();
+	for(size_t r = 0; r < uRounds; ++r)
+	{
+		CSHA1 sha1;
+		if(!sha1.HashFile(tszFileName)) return false;
+		sha1.Final();
+	}
+	double dSeconds = std::chrono::duration<double>(SHA1_CLOCK::now() - tpStart).count();
+	if(dSeconds > 0.0) resultOut.dUserMBps = dMB / dSeconds;
+
+	if(!CSHA1KernelHash::IsAvailable()) return true;
+
+	std::vector<UINT_8> vBuffer(SHA1_KERNEL_READ_BUFFER);
+	tpStart = SHA1_CLOCK::now();
+	for(size_t r = 0; r < uRounds; ++r)
+	{
+		FILE* fp = _tfopen(tszFileName, _T("rb"));
+		if(fp == NULL) return false;
+
+		CSHA1KernelHash k;
+		size_t uRead;
+		while((uRead = fread(&vBuffer[0], 1, vBuffer.size(), fp)) != 0)
+			k.Update(&vBuffer[0], static_cast<UINT_32>(uRead));
+		fclose(fp);
+		k.Final();
+	}
+	dSeconds = std::chrono::duration<double>(SHA1_CLOCK::now() - tpStart).count();
+	if(dSeconds > 0.0) resultOut.dKernelUpdateMBps = dMB / dSeconds;
+
+	tpStart = SHA1_CLOCK::now();
+	for(size_t r = 0; r < uRounds; ++r)
+	{
+		CSHA1KernelHash k;
+		if(!k.HashFile(tszFileName)) return false;
+		k.Final();
+	}
+	dSeconds = std::chrono::duration<double>(SHA1_CLOCK::now() - tpStart).count();
+	if(dSeconds > 0.0) resultOut.dKernelSpliceMBps = dMB / dSeconds;
+
+	return true;
+}
+#endif
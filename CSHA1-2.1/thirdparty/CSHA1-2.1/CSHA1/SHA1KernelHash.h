@@ -0,0 +1,87 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  SHA-1 computed by the Linux kernel crypto API (AF_ALG "hash" socket).
+  See SHA1.h for version history.
+
+  Update sends the data with MSG_MORE; HashFile splices the file pages
+  into the socket through a pipe, so the data never enters user space.
+  This pays off on hosts where the kernel's SHA-1 driver is accelerated
+  (see GetDriverName). If AF_ALG is not available (other systems, kernels
+  without CONFIG_CRYPTO_USER_API_HASH, sandboxes), CSHA1 is used instead
+  with the same results.
+*/
+
+#ifndef SHA1KERNELHASH_H_4F1A8C3E7B2D4E9F8A6C0B1D3E5F7A9C
+#define SHA1KERNELHASH_H_4F1A8C3E7B2D4E9F8A6C0B1D3E5F7A9C
+
+#include <string>
+
+#include "SHA1.h"
+
+class CSHA1KernelHash
+{
+public:
+	CSHA1KernelHash();
+	~CSHA1KernelHash();
+
+	void Reset();
+
+	void Update(const UINT_8* pbData, UINT_32 uLen);
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+	// pControl: see CSHA1::HashFile
+	bool HashFile(const TCHAR* tszFileName, CSHA1HashControl* pControl = NULL);
+#endif
+
+	// Finalize hash; call it before using GetHash
+	void Final();
+
+	// Get the raw message digest (20 bytes)
+	bool GetHash(UINT_8* pbDest20) const;
+
+	// Whether this object uses the kernel (false means CSHA1 fallback)
+	bool IsKernel() const { return (m_fdOp >= 0); }
+
+	// Whether AF_ALG SHA-1 is available on this system
+	static bool IsAvailable();
+
+	// Kernel driver used for SHA-1 (for example "sha1-ni"); empty if
+	// unknown. Read from /proc/crypto.
+	static std::string GetDriverName();
+
+private:
+	bool OpenKernel();
+	void CloseKernel();
+	bool SendKernel(const UINT_8* pbData, size_t uLen);
+
+	CSHA1KernelHash(const CSHA1KernelHash&);
+	CSHA1KernelHash& operator=(const CSHA1KernelHash&);
+
+	int m_fdAlg;
+	int m_fdOp;
+	bool m_bError; // A kernel operation failed; GetHash fails
+	UINT_64 m_uBytes; // Bytes passed to the kernel (for statistics)
+
+	CSHA1 m_sha1; // Fallback
+	UINT_8 m_digest[20];
+};
+
+typedef struct
+{
+	double dUserMBps; // CSHA1::HashFile
+	double dKernelUpdateMBps; // CSHA1KernelHash::Update with a read buffer
+	double dKernelSpliceMBps; // CSHA1KernelHash::HashFile (0 if not available)
+	std::string strDriver;
+} SHA1_BACKEND_BENCHMARK;
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+// Hash the file uRounds times with each backend (use a cached file to
+// compare the hashing rather than the disk)
+bool SHA1BenchmarkBackends(const TCHAR* tszFileName, size_t uRounds,
+	SHA1_BACKEND_BENCHMARK& resultOut);
+#endif
+
+#endif // SHA1KERNELHASH_H_4F1A8C3E7B2D4E9F8A6C0B1D3E5F7A9C
@@ -0,0 +1,110 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+CSHA1MappedFile::CSHA1MappedFile() :
+	m_pbData(NULL), m_uSize(0), m_hFile(INVALID_HANDLE_VALUE), m_hMapping(NULL)
+{
+}
+
+bool CSHA1MappedFile::Open(const TCHAR* tszFileName)
+{
+	Close();
+	if(tszFileName == NULL) return false;
+
+	HANDLE hFile = CreateFile(tszFileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(hFile == INVALID_HANDLE_VALUE) return false;
+	m_hFile = hFile;
+
+	LARGE_INTEGER liSize;
+	if(GetFileSizeEx(hFile, &liSize) == FALSE) { Close(); return false; }
+	if(liSize.QuadPart == 0) return true;
+
+	HANDLE hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(hMapping == NULL) { Close(); return false; }
+	m_hMapping = hMapping;
+
+	m_pbData = static_cast<const UINT_8*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+	if(m_pbData == NULL) { Close(); return false; }
+
+	m_uSize = static_cast<UINT_64>(liSize.QuadPart);
+	return true;
+}
+
+void CSHA1MappedFile::Close()
+{
+	if(m_pbData != NULL) UnmapViewOfFile(m_pbData);
+	if(m_hMapping != NULL) CloseHandle(m_hMapping);
+	if(m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+
+	m_pbData = NULL;
+	m_uSize = 0;
+	m_hMapping = NULL;
+	m_hFile = INVALID_HANDLE_VALUE;
+}
+
+#else // !_WIN32
+
+CSHA1MappedFile::CSHA1MappedFile() :
+	m_pbData(NULL), m_uSize(0)
+{
+}
+
+bool CSHA1MappedFile::Open(const TCHAR* tszFileName)
+{
+	Close();
+	if(tszFileName == NULL) return false;
+
+	const int fd = open(tszFileName, O_RDONLY);
+	if(fd < 0) return false;
+
+	struct stat st;
+	if((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode)) { close(fd); return false; }
+	if(st.st_size == 0) { close(fd); return true; }
+
+	void* pMap = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // The mapping keeps its own reference
+	if(pMap == MAP_FAILED) return false;
+
+	madvise(pMap, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+	m_pbData = static_cast<const UINT_8*>(pMap);
+	m_uSize = static_cast<UINT_64>(st.st_size);
+	return true;
+}
+
+void CSHA1MappedFile::Close()
+{
+	if(m_pbData != NULL)
+		munmap(const_cast<UINT_8*>(m_pbData), static_cast<size_t>(m_uSize));
+
+	m_pbData = NULL;
+	m_uSize = 0;
+}
+
+#endif // _WIN32
+
+CSHA1MappedFile::~CSHA1MappedFile()
+{
+	Close();
+}
@@ -0,0 +1,41 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Read-only memory mapping of a file, used by the CSHA1 utilities.
+  See SHA1.h for version history.
+*/
+
+#ifndef SHA1MAPPEDFILE_H_542B0E7AD61F4287BE8D26CB6DE59BDB
+#define SHA1MAPPEDFILE_H_542B0E7AD61F4287BE8D26CB6DE59BDB
+
+#include "SHA1.h"
+
+class CSHA1MappedFile
+{
+public:
+	CSHA1MappedFile();
+	~CSHA1MappedFile();
+
+	// Map the whole file; empty files succeed with GetData() == NULL
+	bool Open(const TCHAR* tszFileName);
+	void Close();
+
+	const UINT_8* GetData() const { return m_pbData; }
+	UINT_64 GetSize() const { return m_uSize; }
+
+private:
+	CSHA1MappedFile(const CSHA1MappedFile&);
+	CSHA1MappedFile& operator=(const CSHA1MappedFile&);
+
+	const UINT_8* m_pbData;
+	UINT_64 m_uSize;
+
+#ifdef _WIN32
+	void* m_hFile;
+	void* m_hMapping;
+#endif
+};
+
+#endif // SHA1MAPPEDFILE_H_542B0E7AD61F4287BE8D26CB6DE59BDB
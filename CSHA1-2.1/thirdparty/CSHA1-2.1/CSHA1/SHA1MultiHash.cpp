@@ -0,0 +1,212 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1MultiHash.h"
+#include "SHA1BufferArena.h"
+#include "SHA1FileInfo.h"
+#include "SHA1HashControl.h"
+#include "SHA1ThreadPool.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SHA1_CRC32C_X86
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SHA1_TARGET_SSE42
+#else
+#include <cpuid.h>
+#define SHA1_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#endif
+
+// Without the helper thread, data is passed to the algorithms in slices
+// of this size, so that each slice is still cached for the next one
+#define SHA1_MULTI_SLICE (16 * 1024)
+
+#define SHA1_MULTI_FILE_BUFFER (1024 * 1024)
+
+static UINT_32 g_pCrc32cTable[256];
+
+static bool SHA1Crc32cInitTable()
+{
+	for(UINT_32 i = 0; i < 256; ++i)
+	{
+		UINT_32 c = i;
+		for(size_t k = 0; k < 8; ++k)
+			c = (((c & 1) != 0) ? ((c >> 1) ^ 0x82F63B78) : (c >> 1));
+		g_pCrc32cTable[i] = c;
+	}
+
+	return true;
+}
+
+static UINT_32 SHA1Crc32cPortable(UINT_32 uState, const UINT_8* pbData, size_t uLen)
+{
+	static const bool bTable = SHA1Crc32cInitTable();
+	(void)bTable;
+
+	for(size_t i = 0; i < uLen; ++i)
+		uState = g_pCrc32cTable[(uState ^ pbData[i]) & 0xFF] ^ (uState >> 8);
+	return uState;
+}
+
+#ifdef SHA1_CRC32C_X86
+static bool SHA1HasSse42()
+{
+#ifdef _MSC_VER
+	int pInfo[4];
+	__cpuid(pInfo, 1);
+	return ((pInfo[2] & (1 << 20)) != 0);
+#else
+	unsigned int a, b, c, d;
+	if(__get_cpuid(1, &a, &b, &c, &d) == 0) return false;
+	return ((c & (1U << 20)) != 0);
+#endif
+}
+
+SHA1_TARGET_SSE42 static UINT_32 SHA1Crc32cHw(UINT_32 uState, const UINT_8* pbData, size_t uLen)
+{
+	for( ; (uLen != 0) && ((reinterpret_cast<size_t>(pbData) & 7) != 0); --uLen)
+		uState = _mm_crc32_u8(uState, *pbData++);
+
+#if defined(__x86_64__) || defined(_M_X64)
+	UINT_64 uState64 = uState;
+	for( ; uLen >= 8; uLen -= 8, pbData += 8)
+	{
+		UINT_64 uWord;
+		memcpy(&uWord, pbData, 8);
+		uState64 = _mm_crc32_u64(uState64, uWord);
+	}
+	uState = static_cast<UINT_32>(uState64);
+#else
+	for( ; uLen >= 4; uLen -= 4, pbData += 4)
+	{
+		UINT_32 uWord;
+		memcpy(&uWord, pbData, 4);
+		uState = _mm_crc32_u32(uState, uWord);
+	}
+#endif
+
+	for( ; uLen != 0; --uLen)
+		uState = _mm_crc32_u8(uState, *pbData++);
+	return uState;
+}
+#endif
+
+UINT_32 SHA1Crc32c(UINT_32 uCrc, const UINT_8* pbData, size_t uLen)
+{
+	if((pbData == NULL) || (uLen == 0)) return uCrc;
+
+	UINT_32 uState = ~uCrc;
+#ifdef SHA1_CRC32C_X86
+	static const bool bHw = SHA1HasSse42();
+	if(bHw) return ~SHA1Crc32cHw(uState, pbData, uLen);
+#endif
+	return ~SHA1Crc32cPortable(uState, pbData, uLen);
+}
+
+CSHA1MultiHash::CSHA1MultiHash(bool bParallel) :
+	m_uCrc(0), m_pPool(NULL)
+{
+	if(bParallel && (std::thread::hardware_concurrency() > 1))
+		m_pPool = new CSHA1ThreadPool(1);
+}
+
+CSHA1MultiHash::~CSHA1MultiHash()
+{
+	delete m_pPool;
+}
+
+void CSHA1MultiHash::Reset()
+{
+	m_sha1.Reset();
+	m_sha256.Reset();
+	m_uCrc = 0;
+}
+
+void CSHA1MultiHash::Update(const UINT_8* pbData, UINT_32 uLen)
+{
+	if((pbData == NULL) || (uLen == 0)) return;
+
+	if((m_pPool != NULL) && (uLen >= SHA1_MULTI_PARALLEL_MIN))
+	{
+		CSHA256* pSha256 = &m_sha256;
+		UINT_32* pCrc = &m_uCrc;
+		m_pPool->Submit([pSha256, pCrc, pbData, uLen]()
+		{
+			pSha256->Update(pbData, uLen);
+			*pCrc = SHA1Crc32c(*pCrc, pbData, uLen);
+		});
+
+		m_sha1.Update(pbData, uLen);
+		m_pPool->Wait();
+		return;
+	}
+
+	for(UINT_32 uOffset = 0; uOffset < uLen; uOffset += SHA1_MULTI_SLICE)
+	{
+		const UINT_32 uSlice = (((uLen - uOffset) < SHA1_MULTI_SLICE) ?
+			(uLen - uOffset) : SHA1_MULTI_SLICE);
+
+		m_sha1.Update(pbData + uOffset, uSlice);
+		m_sha256.Update(pbData + uOffset, uSlice);
+		m_uCrc = SHA1Crc32c(m_uCrc, pbData + uOffset, uSlice);
+	}
+}
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+bool CSHA1MultiHash::HashFile(const TCHAR* tszFileName, CSHA1HashControl* pControl)
+{
+	if(tszFileName == NULL) return false;
+
+	UINT_8* pbBuffer = CSHA1BufferArena::GetThreadArena().Acquire(SHA1_MULTI_FILE_BUFFER);
+	if(pbBuffer == NULL) return false;
+
+	FILE* fpIn = _tfopen(tszFileName, _T("rb"));
+	if(fpIn == NULL) return false;
+	setvbuf(fpIn, NULL, _IONBF, 0);
+
+	if(pControl != NULL)
+	{
+		SHA1_FILE_ID id;
+		pControl->Begin(SHA1GetFileId(tszFileName, id) ? id.uSize : 0);
+	}
+
+	bool bSuccess = true;
+	while(true)
+	{
+		const size_t uRead = fread(pbBuffer, 1, SHA1_MULTI_FILE_BUFFER, fpIn);
+
+		if(uRead > 0)
+			Update(pbBuffer, static_cast<UINT_32>(uRead));
+
+		if(uRead < SHA1_MULTI_FILE_BUFFER)
+		{
+			if(feof(fpIn) == 0) bSuccess = false;
+			if(pControl != NULL) pControl->End(uRead);
+			break;
+		}
+
+		if((pControl != NULL) && !pControl->Continue(uRead))
+		{
+			bSuccess = false;
+			break;
+		}
+	}
+
+	fclose(fpIn);
+	return bSuccess;
+}
+#endif
+
+void CSHA1MultiHash::Final()
+{
+	m_sha1.Final();
+	m_sha256.Final();
+}
@@ -0,0 +1,75 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  SHA-1, SHA-256 and CRC32C of the same data from a single pass over it.
+  See SHA1.h for version history.
+
+  CSHA1MultiHash has the interface of CSHA1 (the digest returned by
+  GetHash is the SHA-1 one). Each block of data is passed to the three
+  algorithms while it is still in the cache; for large updates SHA-256
+  and CRC32C run on a helper thread while the calling thread computes
+  SHA-1. CRC32C uses the SSE4.2 CRC32 instruction if available.
+
+  ================ Test Vectors ================
+
+  CRC32C("123456789" in ANSI) = E3069283
+*/
+
+#ifndef SHA1MULTIHASH_H_8B3E6D1F2A5C4F7E9D0B1C3A5E7F9B2D
+#define SHA1MULTIHASH_H_8B3E6D1F2A5C4F7E9D0B1C3A5E7F9B2D
+
+#include "SHA1.h"
+#include "SHA256.h"
+
+class CSHA1ThreadPool;
+
+// Updates of at least this many bytes are split across two threads
+#ifndef SHA1_MULTI_PARALLEL_MIN
+#define SHA1_MULTI_PARALLEL_MIN (256 * 1024)
+#endif
+
+// CRC32C (Castagnoli) of the data, continuing from uCrc (0 to start)
+UINT_32 SHA1Crc32c(UINT_32 uCrc, const UINT_8* pbData, size_t uLen);
+
+class CSHA1MultiHash
+{
+public:
+	// bParallel enables the helper thread (if there is more than one core)
+	explicit CSHA1MultiHash(bool bParallel = true);
+	~CSHA1MultiHash();
+
+	void Reset();
+
+	void Update(const UINT_8* pbData, UINT_32 uLen);
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+	// Hash in file contents, reading each byte once
+	// pControl: see CSHA1::HashFile
+	bool HashFile(const TCHAR* tszFileName, CSHA1HashControl* pControl = NULL);
+#endif
+
+	// Finalize all digests; call it before using GetHash
+	void Final();
+
+	// SHA-1 digest (20 bytes)
+	bool GetHash(UINT_8* pbDest20) const { return m_sha1.GetHash(pbDest20); }
+
+	// SHA-256 digest (32 bytes)
+	bool GetSha256(UINT_8* pbDest32) const { return m_sha256.GetHash(pbDest32); }
+
+	UINT_32 GetCrc32c() const { return m_uCrc; }
+
+private:
+	CSHA1MultiHash(const CSHA1MultiHash&);
+	CSHA1MultiHash& operator=(const CSHA1MultiHash&);
+
+	CSHA1 m_sha1;
+	CSHA256 m_sha256;
+	UINT_32 m_uCrc;
+
+	CSHA1ThreadPool* m_pPool; // NULL if not parallel
+};
+
+#endif // SHA1MULTIHASH_H_8B3E6D1F2A5C4F7E9D0B1C3A5E7F9B2D
@@ -0,0 +1,63 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  USDT static tracepoints (provider "csha1"). See SHA1.h for version
+  history.
+
+  The probes are compiled in on Linux if <sys/sdt.h> (systemtap SDT
+  headers) is available, unless SHA1_NO_USDT is defined. An unattached
+  probe is a single nop instruction; durations are only measured while
+  a tracer is attached to the probe (semaphore test).
+
+    file_open(path, size)                 CSHA1::HashFile opened a file
+    chunk_read(bytes, ns)                 A chunk has been read
+    chunk_hash(bytes, ns)                 A chunk has been hashed
+    file_close(path, bytes, ns, success)  CSHA1::HashFile is done
+    final(bytes, backend)                 A message has been finalized
+    kernel_dispatch(backend, mode, bytes) CSHA1KernelHash backend choice;
+                                          mode 0 = user space fallback,
+                                          1 = splice, 2 = read and send
+
+  Backend ids are the SHA1_STATS_KERNEL_* values of SHA1Stats.h. Example:
+
+    bpftrace -e 'usdt:./app:csha1:chunk_read { @read = hist(arg1); }'
+*/
+
+#ifndef SHA1PROBES_H_6D1F8B3A5C2E4F7A9B0D4E6C8A1F3B57
+#define SHA1PROBES_H_6D1F8B3A5C2E4F7A9B0D4E6C8A1F3B57
+
+#if defined(__linux__) && !defined(SHA1_NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define SHA1_USDT
+#endif
+#endif
+
+#ifdef SHA1_USDT
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+// Set by the tracer while a probe is attached (defined in SHA1.cpp)
+extern "C"
+{
+	extern volatile unsigned short csha1_file_open_semaphore;
+	extern volatile unsigned short csha1_chunk_read_semaphore;
+	extern volatile unsigned short csha1_chunk_hash_semaphore;
+	extern volatile unsigned short csha1_file_close_semaphore;
+	extern volatile unsigned short csha1_final_semaphore;
+	extern volatile unsigned short csha1_kernel_dispatch_semaphore;
+}
+
+#define SHA1_PROBE_ENABLED(n) __builtin_expect(csha1_##n##_semaphore != 0, 0)
+#define SHA1_PROBE2(n, a1, a2) STAP_PROBE2(csha1, n, a1, a2)
+#define SHA1_PROBE3(n, a1, a2, a3) STAP_PROBE3(csha1, n, a1, a2, a3)
+#define SHA1_PROBE4(n, a1, a2, a3, a4) STAP_PROBE4(csha1, n, a1, a2, a3, a4)
+#else
+#define SHA1_PROBE_ENABLED(n) false
+#define SHA1_PROBE2(n, a1, a2) ((void)0)
+#define SHA1_PROBE3(n, a1, a2, a3) ((void)0)
+#define SHA1_PROBE4(n, a1, a2, a3, a4) ((void)0)
+#endif
+
+#endif // SHA1PROBES_H_6D1F8B3A5C2E4F7A9B0D4E6C8A1F3B57
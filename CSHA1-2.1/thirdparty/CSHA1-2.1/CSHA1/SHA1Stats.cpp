@@ -0,0 +1,250 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1Stats.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <mutex>
+#include <set>
+
+#define SHA1_STATS_WORDS (sizeof(SHA1_STATS) / sizeof(UINT_64))
+
+#define SHA1_STATS_WORD(m) (offsetof(SHA1_STATS, m) / sizeof(UINT_64))
+
+#ifndef SHA1_NO_STATS
+std::atomic<bool> g_bSHA1StatsEnabled(false);
+#endif
+
+static const char* const g_pKernelNames[SHA1_STATS_KERNELS] =
+	{ "scalar", "af_alg", "sha256_ni", "sha256" };
+
+static const char* const g_pSizeClassNames[SHA1_STATS_SIZE_CLASSES] =
+	{ "4K", "64K", "1M", "16M", "256M", "+Inf" };
+
+// Counters of one thread; only the owning thread writes them
+typedef struct
+{
+	std::atomic<UINT_64> p[SHA1_STATS_WORDS];
+} SHA1_STATS_SLOT;
+
+typedef struct
+{
+	std::mutex mtx;
+	std::set<SHA1_STATS_SLOT*> sSlots;
+	UINT_64 pRetired[SHA1_STATS_WORDS]; // Counters of exited threads
+	UINT_64 pBaseline[SHA1_STATS_WORDS]; // Totals at the last reset
+} SHA1_STATS_REGISTRY;
+
+static SHA1_STATS_REGISTRY& SHA1StatsRegistry()
+{
+	// Never destroyed, as threads may exit after static destruction
+	static SHA1_STATS_REGISTRY* s_pRegistry = new SHA1_STATS_REGISTRY();
+	return *s_pRegistry;
+}
+
+namespace
+{
+	class CSHA1StatsThreadSlot
+	{
+	public:
+		CSHA1StatsThreadSlot()
+		{
+			for(size_t i = 0; i < SHA1_STATS_WORDS; ++i)
+				m_slot.p[i].store(0, std::memory_order_relaxed);
+
+			SHA1_STATS_REGISTRY& r = SHA1StatsRegistry();
+			std::lock_guard<std::mutex> lock(r.mtx);
+			r.sSlots.insert(&m_slot);
+		}
+
+		~CSHA1StatsThreadSlot()
+		{
+			SHA1_STATS_REGISTRY& r = SHA1StatsRegistry();
+			std::lock_guard<std::mutex> lock(r.mtx);
+			for(size_t i = 0; i < SHA1_STATS_WORDS; ++i)
+				r.pRetired[i] += m_slot.p[i].load(std::memory_order_relaxed);
+			r.sSlots.erase(&m_slot);
+		}
+
+		void Add(size_t uWord, UINT_64 uValue)
+		{
+			// Single writer: no read-modify-write instruction needed
+			std::atomic<UINT_64>& a = m_slot.p[uWord];
+			a.store(a.load(std::memory_order_relaxed) + uValue, std::memory_order_relaxed);
+		}
+
+	private:
+		SHA1_STATS_SLOT m_slot;
+	};
+}
+
+static CSHA1StatsThreadSlot& SHA1StatsSlot()
+{
+	static thread_local CSHA1StatsThreadSlot s_slot;
+	return s_slot;
+}
+
+// Sum of all slots; the registry must be locked
+static void SHA1StatsSumLocked(SHA1_STATS_REGISTRY& r, UINT_64* pSum)
+{
+	for(size_t i = 0; i < SHA1_STATS_WORDS; ++i) pSum[i] = r.pRetired[i];
+
+	for(std::set<SHA1_STATS_SLOT*>::const_iterator it = r.sSlots.begin();
+		it != r.sSlots.end(); ++it)
+	{
+		for(size_t i = 0; i < SHA1_STATS_WORDS; ++i)
+			pSum[i] += (*it)->p[i].load(std::memory_order_relaxed);
+	}
+}
+
+void SHA1StatsEnable(bool bEnable)
+{
+#ifndef SHA1_NO_STATS
+	g_pfnSHA1StatsFinal.store(bEnable ? SHA1StatsAddMessage : NULL, std::memory_order_relaxed);
+	g_bSHA1StatsEnabled.store(bEnable, std::memory_order_relaxed);
+#else
+	(void)bEnable;
+#endif
+}
+
+void SHA1StatsGet(SHA1_STATS& statsOut)
+{
+	UINT_64 pSum[SHA1_STATS_WORDS];
+	SHA1_STATS_REGISTRY& r = SHA1StatsRegistry();
+	{
+		std::lock_guard<std::mutex> lock(r.mtx);
+		SHA1StatsSumLocked(r, pSum);
+		for(size_t i = 0; i < SHA1_STATS_WORDS; ++i) pSum[i] -= r.pBaseline[i];
+	}
+
+	memcpy(&statsOut, pSum, sizeof(SHA1_STATS));
+}
+
+void SHA1StatsReset()
+{
+	SHA1_STATS_REGISTRY& r = SHA1StatsRegistry();
+	std::lock_guard<std::mutex> lock(r.mtx);
+	SHA1StatsSumLocked(r, r.pBaseline);
+}
+
+void SHA1StatsAddMessage(int iKernel, UINT_64 uBytes)
+{
+	if((iKernel < 0) || (iKernel >= SHA1_STATS_KERNELS)) return;
+
+	// Padding adds at least 9 bytes (0x80 and the 64-bit length)
+	CSHA1StatsThreadSlot& s = SHA1StatsSlot();
+	s.Add(SHA1_STATS_WORD(uBytesHashed), uBytes);
+	s.Add(SHA1_STATS_WORD(pBlocks) + static_cast<size_t>(iKernel), ((uBytes + 8) >> 6) + 1);
+}
+
+void SHA1StatsAddFile(UINT_64 uBytes, UINT_64 uTotalNs, UINT_64 uReadNs, UINT_64 uHashNs)
+{
+	size_t c = 0;
+	for(UINT_64 uLimit = 4096; (c < (SHA1_STATS_SIZE_CLASSES - 1)) && (uBytes >= uLimit);
+		uLimit <<= 4) ++c;
+
+	size_t b = 0;
+	for(UINT_64 uLimit = 1000; (b < (SHA1_STATS_LATENCY_BUCKETS - 1)) && (uTotalNs > uLimit);
+		uLimit <<= 2) ++b;
+
+	CSHA1StatsThreadSlot& s = SHA1StatsSlot();
+	s.Add(SHA1_STATS_WORD(uReadNs), uReadNs);
+	s.Add(SHA1_STATS_WORD(uHashNs), uHashNs);
+	s.Add(SHA1_STATS_WORD(pFiles) + c, 1);
+	s.Add(SHA1_STATS_WORD(pFileNs) + c, uTotalNs);
+	s.Add(SHA1_STATS_WORD(pLatency) + (c * SHA1_STATS_LATENCY_BUCKETS) + b, 1);
+}
+
+void SHA1StatsAddArena(bool bHit)
+{
+	if(bHit) SHA1StatsSlot().Add(SHA1_STATS_WORD(uArenaHits), 1);
+	else SHA1StatsSlot().Add(SHA1_STATS_WORD(uArenaMisses), 1);
+}
+
+static void SHA1StatsAppend(std::string& str, const char* pszFormat, ...)
+{
+	char pszLine[256];
+	va_list args;
+	va_start(args, pszFormat);
+	const int n = vsnprintf(pszLine, sizeof(pszLine), pszFormat, args);
+	va_end(args);
+
+	if(n > 0) str.append(pszLine, ((static_cast<size_t>(n) < sizeof(pszLine)) ?
+		static_cast<size_t>(n) : (sizeof(pszLine) - 1)));
+}
+
+static void SHA1StatsAppendHeader(std::string& str, const char* pszName, const char* pszType,
+	const char* pszHelp)
+{
+	SHA1StatsAppend(str, "# HELP %s %s\n# TYPE %s %s\n", pszName, pszHelp, pszName, pszType);
+}
+
+std::string SHA1StatsFormatPrometheus(const SHA1_STATS& stats)
+{
+	std::string str;
+
+	SHA1StatsAppendHeader(str, "sha1_bytes_hashed_total", "counter",
+		"Message bytes hashed (counted when finalized).");
+	SHA1StatsAppend(str, "sha1_bytes_hashed_total %llu\n",
+		static_cast<unsigned long long>(stats.uBytesHashed));
+
+	SHA1StatsAppendHeader(str, "sha1_blocks_total", "counter",
+		"Compressed 64-byte blocks per kernel.");
+	for(size_t k = 0; k < SHA1_STATS_KERNELS; ++k)
+		SHA1StatsAppend(str, "sha1_blocks_total{kernel=\"%s\"} %llu\n", g_pKernelNames[k],
+			static_cast<unsigned long long>(stats.pBlocks[k]));
+
+	SHA1StatsAppendHeader(str, "sha1_file_read_seconds_total", "counter",
+		"Time spent reading files.");
+	SHA1StatsAppend(str, "sha1_file_read_seconds_total %.9f\n",
+		static_cast<double>(stats.uReadNs) / 1e9);
+
+	SHA1StatsAppendHeader(str, "sha1_file_hash_seconds_total", "counter",
+		"Time spent hashing file data.");
+	SHA1StatsAppend(str, "sha1_file_hash_seconds_total %.9f\n",
+		static_cast<double>(stats.uHashNs) / 1e9);
+
+	SHA1StatsAppendHeader(str, "sha1_file_duration_seconds", "histogram",
+		"Latency of hashing a file, per file size class (upper bound in bytes).");
+	for(size_t c = 0; c < SHA1_STATS_SIZE_CLASSES; ++c)
+	{
+		UINT_64 uCumulative = 0;
+		double dBound = 1e-6;
+		for(size_t b = 0; b < SHA1_STATS_LATENCY_BUCKETS; ++b, dBound *= 4.0)
+		{
+			uCumulative += stats.pLatency[c][b];
+			if(b == (SHA1_STATS_LATENCY_BUCKETS - 1))
+				SHA1StatsAppend(str, "sha1_file_duration_seconds_bucket{size=\"%s\",le=\"+Inf\"} %llu\n",
+					g_pSizeClassNames[c], static_cast<unsigned long long>(uCumulative));
+			else
+				SHA1StatsAppend(str, "sha1_file_duration_seconds_bucket{size=\"%s\",le=\"%.9g\"} %llu\n",
+					g_pSizeClassNames[c], dBound, static_cast<unsigned long long>(uCumulative));
+		}
+
+		SHA1StatsAppend(str, "sha1_file_duration_seconds_sum{size=\"%s\"} %.9f\n",
+			g_pSizeClassNames[c], static_cast<double>(stats.pFileNs[c]) / 1e9);
+		SHA1StatsAppend(str, "sha1_file_duration_seconds_count{size=\"%s\"} %llu\n",
+			g_pSizeClassNames[c], static_cast<unsigned long long>(stats.pFiles[c]));
+	}
+
+	SHA1StatsAppendHeader(str, "sha1_arena_hits_total", "counter",
+		"Buffer arena requests served by the existing buffer.");
+	SHA1StatsAppend(str, "sha1_arena_hits_total %llu\n",
+		static_cast<unsigned long long>(stats.uArenaHits));
+
+	SHA1StatsAppendHeader(str, "sha1_arena_misses_total", "counter",
+		"Buffer arena requests that allocated a buffer.");
+	SHA1StatsAppend(str, "sha1_arena_misses_total %llu\n",
+		static_cast<unsigned long long>(stats.uArenaMisses));
+
+	return str;
+}
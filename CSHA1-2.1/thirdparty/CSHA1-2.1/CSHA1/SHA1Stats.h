@@ -0,0 +1,100 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Opt-in statistics of the hashing functions. See SHA1.h for version
+  history.
+
+  Statistics are off by default; while off, each instrumented function
+  only tests one flag. When enabled with SHA1StatsEnable, every thread
+  counts into its own slot (no locked instructions, no shared cache
+  lines); SHA1StatsGet merges all slots into a snapshot. Define
+  SHA1_NO_STATS to compile the instrumentation out completely.
+
+  Collected are:
+  - message bytes and compressed blocks per kernel, counted when a
+    message is finalized (Final),
+  - time spent reading vs. hashing in the file hashing functions,
+  - files per size class with latency histograms,
+  - buffer arena hits (buffer reused) and misses (buffer allocated).
+
+  SHA1StatsFormatPrometheus renders a snapshot in the Prometheus text
+  exposition format.
+*/
+
+#ifndef SHA1STATS_H_2C7E9A4F1B3D4E8A9C6F0B5D7E2A4C18
+#define SHA1STATS_H_2C7E9A4F1B3D4E8A9C6F0B5D7E2A4C18
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "SHA1.h"
+
+// Hash kernels
+#define SHA1_STATS_KERNEL_SCALAR 0 // CSHA1
+#define SHA1_STATS_KERNEL_AF_ALG 1 // CSHA1KernelHash (Linux kernel crypto API)
+#define SHA1_STATS_KERNEL_SHA256_NI 2 // CSHA256 using SHA extensions
+#define SHA1_STATS_KERNEL_SHA256 3 // CSHA256, portable
+#define SHA1_STATS_KERNELS 4
+
+// File size classes: < 4 KB, < 64 KB, < 1 MB, < 16 MB, < 256 MB, larger
+#define SHA1_STATS_SIZE_CLASSES 6
+
+// Latency buckets: <= 1 us, 4 us, 16 us, ... (factor 4), the last one
+// is unbounded
+#define SHA1_STATS_LATENCY_BUCKETS 15
+
+typedef struct
+{
+	UINT_64 uBytesHashed;
+	UINT_64 pBlocks[SHA1_STATS_KERNELS];
+
+	UINT_64 uReadNs; // Time in file reads
+	UINT_64 uHashNs; // Time in compression of file data
+
+	UINT_64 pFiles[SHA1_STATS_SIZE_CLASSES];
+	UINT_64 pFileNs[SHA1_STATS_SIZE_CLASSES]; // Sum of file latencies
+	UINT_64 pLatency[SHA1_STATS_SIZE_CLASSES][SHA1_STATS_LATENCY_BUCKETS]; // Not cumulative
+
+	UINT_64 uArenaHits;
+	UINT_64 uArenaMisses;
+} SHA1_STATS;
+
+// Called by CSHA1::Final while statistics are enabled (SHA1StatsAddMessage);
+// a hook, so that SHA1.cpp does not depend on this module
+typedef void (*SHA1_STATS_MESSAGE_HOOK)(int iKernel, UINT_64 uBytes);
+
+#ifndef SHA1_NO_STATS
+extern std::atomic<bool> g_bSHA1StatsEnabled;
+extern std::atomic<SHA1_STATS_MESSAGE_HOOK> g_pfnSHA1StatsFinal; // Defined in SHA1.cpp
+
+inline bool SHA1StatsEnabled() { return g_bSHA1StatsEnabled.load(std::memory_order_relaxed); }
+#else
+inline bool SHA1StatsEnabled() { return false; }
+#endif
+
+void SHA1StatsEnable(bool bEnable);
+
+// Snapshot of all threads' counters since the last reset
+void SHA1StatsGet(SHA1_STATS& statsOut);
+void SHA1StatsReset();
+
+std::string SHA1StatsFormatPrometheus(const SHA1_STATS& stats);
+
+// Used by the hashing functions; only call these if SHA1StatsEnabled()
+void SHA1StatsAddMessage(int iKernel, UINT_64 uBytes);
+void SHA1StatsAddFile(UINT_64 uBytes, UINT_64 uTotalNs, UINT_64 uReadNs, UINT_64 uHashNs);
+void SHA1StatsAddArena(bool bHit);
+
+typedef std::chrono::steady_clock SHA1_STATS_CLOCK;
+
+inline UINT_64 SHA1StatsNs(const SHA1_STATS_CLOCK::time_point& tpFrom,
+	const SHA1_STATS_CLOCK::time_point& tpTo)
+{
+	return static_cast<UINT_64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		tpTo - tpFrom).count());
+}
+
+#endif // SHA1STATS_H_2C7E9A4F1B3D4E8A9C6F0B5D7E2A4C18
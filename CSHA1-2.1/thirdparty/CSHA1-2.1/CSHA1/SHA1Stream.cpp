@@ -0,0 +1,150 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1Stream.h"
+
+static void SHA1StreamUpdate(CSHA1& sha1, const char* pch, std::streamsize n)
+{
+	if(n <= 0) return;
+
+	SHA1_IOVEC v;
+	v.iov_base = const_cast<char*>(pch);
+	v.iov_len = static_cast<size_t>(n);
+	sha1.UpdateV(&v, 1);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// CSHA1OStreamBuf
+
+CSHA1OStreamBuf::CSHA1OStreamBuf(CSHA1& sha1, std::streambuf* pTarget) :
+	m_sha1(sha1), m_pTarget(pTarget)
+{
+	setp(m_buffer, m_buffer + SHA1_STREAM_BUFFER);
+}
+
+CSHA1OStreamBuf::~CSHA1OStreamBuf()
+{
+	FlushPutArea();
+}
+
+bool CSHA1OStreamBuf::FlushPutArea()
+{
+	const std::streamsize n = pptr() - pbase();
+	if(n == 0) return true;
+
+	std::streamsize nWritten = n;
+	if(m_pTarget != NULL) nWritten = m_pTarget->sputn(pbase(), n);
+
+	// Only hash what actually went through; a full put area is a
+	// multiple of 64 bytes and is hashed in place
+	SHA1StreamUpdate(m_sha1, pbase(), nWritten);
+	setp(m_buffer, m_buffer + SHA1_STREAM_BUFFER);
+
+	return (nWritten == n);
+}
+
+CSHA1OStreamBuf::int_type CSHA1OStreamBuf::overflow(int_type ch)
+{
+	if(!FlushPutArea()) return traits_type::eof();
+
+	if(!traits_type::eq_int_type(ch, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(ch);
+		pbump(1);
+		return ch;
+	}
+
+	return traits_type::not_eof(ch);
+}
+
+std::streamsize CSHA1OStreamBuf::xsputn(const char* pch, std::streamsize n)
+{
+	// Small writes are collected in the put area
+	if(n < (epptr() - pptr())) return std::streambuf::xsputn(pch, n);
+
+	if(!FlushPutArea()) return 0;
+
+	// Large writes bypass the put area and are hashed from the caller's buffer
+	std::streamsize nWritten = n;
+	if(m_pTarget != NULL) nWritten = m_pTarget->sputn(pch, n);
+
+	SHA1StreamUpdate(m_sha1, pch, nWritten);
+	return nWritten;
+}
+
+int CSHA1OStreamBuf::sync()
+{
+	if(!FlushPutArea()) return -1;
+
+	if(m_pTarget != NULL) return m_pTarget->pubsync();
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// CSHA1IStreamBuf
+
+CSHA1IStreamBuf::CSHA1IStreamBuf(CSHA1& sha1, std::streambuf* pSource) :
+	m_sha1(sha1), m_pSource(pSource)
+{
+	setg(m_buffer, m_buffer, m_buffer);
+}
+
+CSHA1IStreamBuf::~CSHA1IStreamBuf()
+{
+	HashConsumed();
+}
+
+// Everything in [eback, gptr) has been consumed but not hashed yet
+void CSHA1IStreamBuf::HashConsumed()
+{
+	SHA1StreamUpdate(m_sha1, eback(), gptr() - eback());
+	setg(gptr(), gptr(), egptr());
+}
+
+CSHA1IStreamBuf::int_type CSHA1IStreamBuf::underflow()
+{
+	if(gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+	HashConsumed();
+	if(m_pSource == NULL) return traits_type::eof();
+
+	const std::streamsize nRead = m_pSource->sgetn(m_buffer, SHA1_STREAM_BUFFER);
+	setg(m_buffer, m_buffer, m_buffer + ((nRead > 0) ? nRead : 0));
+
+	if(nRead <= 0) return traits_type::eof();
+	return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize CSHA1IStreamBuf::xsgetn(char* pch, std::streamsize n)
+{
+	const std::streamsize nAvail = egptr() - gptr();
+	if((n <= nAvail) || (m_pSource == NULL) || ((n - nAvail) < SHA1_STREAM_BUFFER))
+		return std::streambuf::xsgetn(pch, n);
+
+	// Drain the get area, then read directly into the caller's buffer
+	if(nAvail > 0)
+	{
+		memcpy(pch, gptr(), static_cast<size_t>(nAvail));
+		setg(eback(), egptr(), egptr());
+	}
+	HashConsumed();
+	setg(m_buffer, m_buffer, m_buffer);
+
+	std::streamsize nRead = m_pSource->sgetn(pch + nAvail, n - nAvail);
+	if(nRead < 0) nRead = 0;
+
+	SHA1StreamUpdate(m_sha1, pch + nAvail, nRead);
+	return (nAvail + nRead);
+}
+
+int CSHA1IStreamBuf::sync()
+{
+	HashConsumed();
+	return 0;
+}
@@ -0,0 +1,101 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Stream adapters for the CSHA1 class. See SHA1.h for version history.
+
+  CSHA1OStreamBuf hashes everything that is written to it. Without a
+  target it is a digest-only sink; with a target it hashes the data and
+  forwards it (tee). Complete 64-byte blocks are hashed directly out of
+  the put area, large writes are hashed directly out of the caller's
+  buffer.
+
+  CSHA1IStreamBuf reads from a source streambuf and hashes the data
+  that has been consumed by the reader.
+
+  Both adapters hash into a CSHA1 object owned by the caller. Flush the
+  stream (or destroy the adapter) before calling CSHA1::Final.
+*/
+
+#ifndef SHA1STREAM_H_B5F97B68378145E4B099C81C2CE7E1CD
+#define SHA1STREAM_H_B5F97B68378145E4B099C81C2CE7E1CD
+
+#include <streambuf>
+#include <istream>
+#include <ostream>
+
+#include "SHA1.h"
+
+// Size of the put/get areas; must be a multiple of 64
+#ifndef SHA1_STREAM_BUFFER
+#define SHA1_STREAM_BUFFER (64 * 256)
+#endif
+
+class CSHA1OStreamBuf : public std::streambuf
+{
+public:
+	// If pTarget is NULL, the data is only hashed
+	explicit CSHA1OStreamBuf(CSHA1& sha1, std::streambuf* pTarget = NULL);
+	virtual ~CSHA1OStreamBuf();
+
+protected:
+	virtual int_type overflow(int_type ch);
+	virtual std::streamsize xsputn(const char* pch, std::streamsize n);
+	virtual int sync();
+
+private:
+	bool FlushPutArea();
+
+	CSHA1OStreamBuf(const CSHA1OStreamBuf&);
+	CSHA1OStreamBuf& operator=(const CSHA1OStreamBuf&);
+
+	CSHA1& m_sha1;
+	std::streambuf* m_pTarget;
+	char m_buffer[SHA1_STREAM_BUFFER];
+};
+
+class CSHA1IStreamBuf : public std::streambuf
+{
+public:
+	CSHA1IStreamBuf(CSHA1& sha1, std::streambuf* pSource);
+	virtual ~CSHA1IStreamBuf();
+
+protected:
+	virtual int_type underflow();
+	virtual std::streamsize xsgetn(char* pch, std::streamsize n);
+	virtual int sync();
+
+private:
+	void HashConsumed();
+
+	CSHA1IStreamBuf(const CSHA1IStreamBuf&);
+	CSHA1IStreamBuf& operator=(const CSHA1IStreamBuf&);
+
+	CSHA1& m_sha1;
+	std::streambuf* m_pSource;
+	char m_buffer[SHA1_STREAM_BUFFER];
+};
+
+// Convenience stream classes owning their adapter
+class CSHA1OStream : public std::ostream
+{
+public:
+	explicit CSHA1OStream(CSHA1& sha1, std::streambuf* pTarget = NULL) :
+		std::ostream(NULL), m_buf(sha1, pTarget) { rdbuf(&m_buf); }
+
+private:
+	CSHA1OStreamBuf m_buf;
+};
+
+class CSHA1IStream : public std::istream
+{
+public:
+	CSHA1IStream(CSHA1& sha1, std::streambuf* pSource) :
+		std::istream(NULL), m_buf(sha1, pSource) { rdbuf(&m_buf); }
+
+private:
+	CSHA1IStreamBuf m_buf;
+};
+
+#endif // SHA1STREAM_H_B5F97B68378145E4B099C81C2CE7E1CD
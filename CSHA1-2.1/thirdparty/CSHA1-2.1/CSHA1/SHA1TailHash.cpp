@@ -0,0 +1,264 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1TailHash.h"
+#include "SHA1HashControl.h"
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+
+#include <vector>
+
+#include <errno.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// State file format, all integers little endian:
+//   Header: "CSHA1TH" 0x00, UINT_32 version, UINT_32 sizeof(TCHAR),
+//           UINT_64 number of entries
+//   Entry: UINT_32 path length in TCHARs, path (TCHARs in native byte
+//          order), device, inode, offset (8 bytes each), state
+//          (SHA1_STATE_SIZE bytes, see CSHA1::SaveState)
+//   Trailer: SHA-1 digest of all preceding bytes
+#define SHA1_TAIL_VERSION 1
+#define SHA1_TAIL_HEADER 24
+
+static const UINT_8 g_pbTailMagic[8] = { 'C', 'S', 'H', 'A', '1', 'T', 'H', 0 };
+
+static void SHA1TailPut(std::vector<UINT_8>& v, UINT_64 u, size_t uBytes)
+{
+	for(size_t i = 0; i < uBytes; ++i) v.push_back(static_cast<UINT_8>((u >> (i * 8)) & 0xFF));
+}
+
+static UINT_64 SHA1TailGet(const UINT_8* pb, size_t uBytes)
+{
+	UINT_64 u = 0;
+	for(size_t i = 0; i < uBytes; ++i) u |= (static_cast<UINT_64>(pb[i]) << (i * 8));
+	return u;
+}
+
+static void SHA1TailDigest(const std::vector<UINT_8>& v, size_t uLen, UINT_8* pbHash20Out)
+{
+	CSHA1 sha1;
+	SHA1_IOVEC iov;
+	iov.iov_base = const_cast<UINT_8*>(v.data());
+	iov.iov_len = uLen;
+	sha1.UpdateV(&iov, 1);
+	sha1.Final();
+	sha1.GetHash(pbHash20Out);
+}
+
+bool CSHA1TailHash::HashFile(const TCHAR* tszFileName, UINT_8* pbHash20Out,
+	bool* pbRestarted, CSHA1HashControl* pControl)
+{
+	if(pbRestarted != NULL) *pbRestarted = false;
+	if((tszFileName == NULL) || (pbHash20Out == NULL)) return false;
+
+	SHA1_FILE_ID id;
+	if(!SHA1GetFileId(tszFileName, id)) return false;
+
+	const std::basic_string<TCHAR> strKey(tszFileName);
+	TAIL_ENTRY e;
+	bool bResume = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		std::unordered_map<std::basic_string<TCHAR>, TAIL_ENTRY>::const_iterator it =
+			m_mapEntries.find(strKey);
+		if(it != m_mapEntries.end())
+		{
+			e = it->second;
+			bResume = ((e.uDevice == id.uDevice) && (e.uInode == id.uInode) &&
+				(e.uOffset <= id.uSize));
+			if((pbRestarted != NULL) && !bResume) *pbRestarted = true;
+		}
+	}
+
+	CSHA1 sha1;
+	bool bSuccess;
+	if(!bResume) bSuccess = sha1.HashFile(tszFileName, NULL, pControl);
+	else if(e.uOffset == id.uSize) bSuccess = sha1.LoadState(e.pbState, sizeof(e.pbState));
+	else bSuccess = sha1.ResumeHashFile(tszFileName, e.pbState, sizeof(e.pbState), NULL,
+		pControl);
+
+	// A cancelled job has hashed a consistent prefix; keep it
+	const bool bCancelled = (!bSuccess && (pControl != NULL) && pControl->WasCancelled());
+	if(bSuccess || bCancelled)
+	{
+		e.uDevice = id.uDevice;
+		e.uInode = id.uInode;
+		e.uOffset = sha1.GetByteCount();
+		sha1.SaveState(e.pbState, sizeof(e.pbState));
+
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_mapEntries[strKey] = e;
+	}
+	if(!bSuccess) return false;
+
+	sha1.Final();
+	sha1.GetHash(pbHash20Out);
+	return true;
+}
+
+UINT_64 CSHA1TailHash::GetOffset(const TCHAR* tszFileName) const
+{
+	if(tszFileName == NULL) return 0;
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+	std::unordered_map<std::basic_string<TCHAR>, TAIL_ENTRY>::const_iterator it =
+		m_mapEntries.find(std::basic_string<TCHAR>(tszFileName));
+	return ((it != m_mapEntries.end()) ? it->second.uOffset : 0);
+}
+
+void CSHA1TailHash::Forget(const TCHAR* tszFileName)
+{
+	if(tszFileName == NULL) return;
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_mapEntries.erase(std::basic_string<TCHAR>(tszFileName));
+}
+
+void CSHA1TailHash::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_mapEntries.clear();
+}
+
+size_t CSHA1TailHash::GetEntryCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	return m_mapEntries.size();
+}
+
+bool CSHA1TailHash::Save(const TCHAR* tszStateFile) const
+{
+	if(tszStateFile == NULL) return false;
+
+	std::vector<UINT_8> v(g_pbTailMagic, g_pbTailMagic + 8);
+	SHA1TailPut(v, SHA1_TAIL_VERSION, 4);
+	SHA1TailPut(v, sizeof(TCHAR), 4);
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		SHA1TailPut(v, m_mapEntries.size(), 8);
+		for(std::unordered_map<std::basic_string<TCHAR>, TAIL_ENTRY>::const_iterator it =
+			m_mapEntries.begin(); it != m_mapEntries.end(); ++it)
+		{
+			const UINT_8* pbPath = reinterpret_cast<const UINT_8*>(it->first.c_str());
+			SHA1TailPut(v, it->first.size(), 4);
+			v.insert(v.end(), pbPath, pbPath + (it->first.size() * sizeof(TCHAR)));
+			SHA1TailPut(v, it->second.uDevice, 8);
+			SHA1TailPut(v, it->second.uInode, 8);
+			SHA1TailPut(v, it->second.uOffset, 8);
+			v.insert(v.end(), it->second.pbState, it->second.pbState + SHA1_STATE_SIZE);
+		}
+	}
+
+	const size_t uLen = v.size();
+	v.resize(uLen + 20);
+	SHA1TailDigest(v, uLen, &v[uLen]);
+
+	const std::basic_string<TCHAR> strFile(tszStateFile);
+	const std::basic_string<TCHAR> strTemp = strFile + _T(".tmp");
+	FILE* fp = _tfopen(strTemp.c_str(), _T("wb"));
+	if(fp == NULL) return false;
+
+	// The new file must be durable before it replaces the old one
+	bool bSuccess = (fwrite(v.data(), 1, v.size(), fp) == v.size());
+	if(bSuccess) bSuccess = (fflush(fp) == 0);
+#ifdef _WIN32
+	if(bSuccess) bSuccess = (_commit(_fileno(fp)) == 0);
+#else
+	if(bSuccess) bSuccess = (fsync(fileno(fp)) == 0);
+#endif
+	if(fclose(fp) != 0) bSuccess = false;
+
+#ifdef _WIN32
+	if(bSuccess) bSuccess = (MoveFileEx(strTemp.c_str(), strFile.c_str(),
+		MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE);
+#else
+	if(bSuccess) bSuccess = (rename(strTemp.c_str(), strFile.c_str()) == 0);
+#endif
+	return bSuccess;
+}
+
+bool CSHA1TailHash::Load(const TCHAR* tszStateFile)
+{
+	if(tszStateFile == NULL) return false;
+
+	std::unordered_map<std::basic_string<TCHAR>, TAIL_ENTRY> mapEntries;
+
+	FILE* fp = _tfopen(tszStateFile, _T("rb"));
+	if(fp == NULL)
+	{
+		if(errno != ENOENT) return false;
+
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_mapEntries.swap(mapEntries);
+		return true;
+	}
+
+	std::vector<UINT_8> v;
+	UINT_8 pbBuf[4096];
+	size_t uRead;
+	while((uRead = fread(pbBuf, 1, sizeof(pbBuf), fp)) > 0)
+		v.insert(v.end(), pbBuf, pbBuf + uRead);
+	const bool bError = (ferror(fp) != 0);
+	fclose(fp);
+	if(bError || (v.size() < (SHA1_TAIL_HEADER + 20))) return false;
+
+	const size_t uLen = v.size() - 20;
+	UINT_8 pbDigest[20];
+	SHA1TailDigest(v, uLen, pbDigest);
+	if(memcmp(pbDigest, &v[uLen], 20) != 0) return false;
+
+	const UINT_8* pb = v.data();
+	if((memcmp(pb, g_pbTailMagic, 8) != 0) || (SHA1TailGet(&pb[8], 4) != SHA1_TAIL_VERSION) ||
+		(SHA1TailGet(&pb[12], 4) != sizeof(TCHAR)))
+		return false;
+
+	const UINT_64 uCount = SHA1TailGet(&pb[16], 8);
+	size_t uPos = SHA1_TAIL_HEADER;
+	for(UINT_64 i = 0; i < uCount; ++i)
+	{
+		if((uLen - uPos) < 4) return false;
+		const size_t uChars = static_cast<size_t>(SHA1TailGet(&pb[uPos], 4));
+		uPos += 4;
+		if(((uLen - uPos) / sizeof(TCHAR)) < uChars) return false;
+		std::basic_string<TCHAR> strPath(uChars, 0);
+		if(uChars != 0) memcpy(&strPath[0], &pb[uPos], uChars * sizeof(TCHAR));
+		uPos += uChars * sizeof(TCHAR);
+
+		if((uLen - uPos) < (24 + SHA1_STATE_SIZE)) return false;
+		TAIL_ENTRY e;
+		e.uDevice = SHA1TailGet(&pb[uPos], 8);
+		e.uInode = SHA1TailGet(&pb[uPos + 8], 8);
+		e.uOffset = SHA1TailGet(&pb[uPos + 16], 8);
+		memcpy(e.pbState, &pb[uPos + 24], SHA1_STATE_SIZE);
+		uPos += 24 + SHA1_STATE_SIZE;
+
+		// The state must be usable and cover exactly the stored offset
+		CSHA1 sha1;
+		if(!sha1.LoadState(e.pbState, sizeof(e.pbState)) || (sha1.GetByteCount() != e.uOffset))
+			return false;
+
+		mapEntries[strPath] = e;
+	}
+	if(uPos != uLen) return false;
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_mapEntries.swap(mapEntries);
+	return true;
+}
+
+#endif // SHA1_UTILITY_FUNCTIONS
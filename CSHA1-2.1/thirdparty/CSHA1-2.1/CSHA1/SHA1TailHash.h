@@ -0,0 +1,82 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Incremental digests of append-only files (logs). See SHA1.h for version
+  history.
+
+  For each file the intermediate state (CSHA1::SaveState) and the number
+  of bytes hashed are kept. HashFile only reads the bytes appended since
+  the previous call and finalizes a copy of the state, so the cost of a
+  poll depends on the appended bytes, not on the file size. The file is
+  hashed from the beginning again if it has been replaced (different
+  device or inode, e.g. rotated) or has become shorter (truncated).
+
+  Files modified in place without becoming shorter are not detected;
+  use CSHA1HashCache or CSHA1::HashFile for such files.
+
+  Save and Load keep the entries across restarts, so that a restarted
+  process continues with the appended bytes as well. Paths are stored as
+  given (relative paths are resolved against the current directory of
+  the process calling HashFile).
+*/
+
+#ifndef SHA1TAILHASH_H_5E8A2C4F7B1D4A69B3E0C6D8F2A7B514
+#define SHA1TAILHASH_H_5E8A2C4F7B1D4A69B3E0C6D8F2A7B514
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "SHA1.h"
+#include "SHA1FileInfo.h"
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+
+class CSHA1TailHash
+{
+public:
+	CSHA1TailHash() { }
+
+	// Returns the digest of the whole file. pbRestarted is set to true if
+	// a stored state was discarded because the file has been replaced or
+	// truncated. If pControl cancels hashing, the progress is kept and
+	// the next call continues from there.
+	bool HashFile(const TCHAR* tszFileName, UINT_8* pbHash20Out, bool* pbRestarted = NULL,
+		CSHA1HashControl* pControl = NULL);
+
+	// Number of bytes of the file covered by the stored state (0 if none)
+	UINT_64 GetOffset(const TCHAR* tszFileName) const;
+
+	void Forget(const TCHAR* tszFileName);
+	void Clear();
+
+	size_t GetEntryCount() const;
+
+	// Write all entries to a file (replaced atomically). Load replaces the
+	// current entries with those of such a file; a missing file yields no
+	// entries. Load fails without changing anything if the file is not a
+	// state file or is damaged.
+	bool Save(const TCHAR* tszStateFile) const;
+	bool Load(const TCHAR* tszStateFile);
+
+private:
+	struct TAIL_ENTRY
+	{
+		UINT_64 uDevice;
+		UINT_64 uInode;
+		UINT_64 uOffset;
+		UINT_8 pbState[SHA1_STATE_SIZE];
+	};
+
+	CSHA1TailHash(const CSHA1TailHash&);
+	CSHA1TailHash& operator=(const CSHA1TailHash&);
+
+	std::unordered_map<std::basic_string<TCHAR>, TAIL_ENTRY> m_mapEntries;
+	mutable std::mutex m_mtx;
+};
+
+#endif // SHA1_UTILITY_FUNCTIONS
+
+#endif // SHA1TAILHASH_H_5E8A2C4F7B1D4A69B3E0C6D8F2A7B514
@@ -0,0 +1,74 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#include "SHA1ThreadPool.h"
+
+CSHA1ThreadPool::CSHA1ThreadPool(size_t uThreads) :
+	m_uActive(0), m_bStop(false)
+{
+	if(uThreads == 0) uThreads = std::thread::hardware_concurrency();
+	if(uThreads == 0) uThreads = 1;
+
+	for(size_t i = 0; i < uThreads; ++i)
+		m_vThreads.push_back(std::thread(&CSHA1ThreadPool::WorkerMain, this));
+}
+
+CSHA1ThreadPool::~CSHA1ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_bStop = true;
+	}
+	m_cvTask.notify_all();
+
+	for(size_t i = 0; i < m_vThreads.size(); ++i)
+		m_vThreads[i].join();
+}
+
+void CSHA1ThreadPool::Submit(const std::function<void()>& fnTask)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_qTasks.push_back(fnTask);
+	}
+	m_cvTask.notify_one();
+}
+
+void CSHA1ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	while(!m_qTasks.empty() || (m_uActive != 0))
+		m_cvIdle.wait(lock);
+}
+
+void CSHA1ThreadPool::WorkerMain()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	while(true)
+	{
+		while(m_qTasks.empty() && !m_bStop)
+			m_cvTask.wait(lock);
+
+		// Remaining tasks are still run when stopping
+		if(m_qTasks.empty()) break;
+
+		std::function<void()> fnTask;
+		fnTask.swap(m_qTasks.front());
+		m_qTasks.pop_front();
+		++m_uActive;
+
+		lock.unlock();
+		fnTask();
+		lock.lock();
+
+		--m_uActive;
+		if(m_qTasks.empty() && (m_uActive == 0))
+			m_cvIdle.notify_all();
+	}
+}
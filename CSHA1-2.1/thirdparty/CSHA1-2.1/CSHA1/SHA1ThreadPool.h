@@ -0,0 +1,49 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Simple fixed-size worker pool used by the parallel CSHA1 utilities.
+  See SHA1.h for version history.
+*/
+
+#ifndef SHA1THREADPOOL_H_BF3DA5FEE99E4653831AFB9B21D7B062
+#define SHA1THREADPOOL_H_BF3DA5FEE99E4653831AFB9B21D7B062
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CSHA1ThreadPool
+{
+public:
+	// If uThreads is 0, one thread per hardware thread is created
+	explicit CSHA1ThreadPool(size_t uThreads = 0);
+	~CSHA1ThreadPool();
+
+	void Submit(const std::function<void()>& fnTask);
+
+	// Wait until all tasks submitted so far have completed
+	void Wait();
+
+	size_t GetThreadCount() const { return m_vThreads.size(); }
+
+private:
+	void WorkerMain();
+
+	CSHA1ThreadPool(const CSHA1ThreadPool&);
+	CSHA1ThreadPool& operator=(const CSHA1ThreadPool&);
+
+	std::vector<std::thread> m_vThreads;
+	std::deque<std::function<void()> > m_qTasks;
+	std::mutex m_mtx;
+	std::condition_variable m_cvTask;
+	std::condition_variable m_cvIdle;
+	size_t m_uActive;
+	bool m_bStop;
+};
+
+#endif // SHA1THREADPOOL_H_BF3DA5FEE99E4653831AFB9B21D7B062
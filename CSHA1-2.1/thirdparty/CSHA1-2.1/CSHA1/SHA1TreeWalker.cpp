@@ -0,0 +1,406 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "SHA1TreeWalker.h"
+
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define SHA1_WALK_SEPARATOR _T('\\')
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SHA1_WALK_SEPARATOR '/'
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#if defined(STATX_INO) && defined(SYS_getdents64)
+#define SHA1_WALK_LINUX
+#endif
+#endif
+#endif
+
+#ifdef SHA1_WALK_LINUX
+// Record returned by getdents64
+typedef struct
+{
+	UINT_64 d_ino;
+	INT_64 d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[1];
+} SHA1_DIRENT64;
+
+// Only the fields of SHA1_FILE_ID, the type and the link count
+#define SHA1_WALK_STATX_MASK (STATX_TYPE | STATX_NLINK | STATX_INO | STATX_SIZE | \
+	STATX_MTIME | STATX_CTIME)
+#endif
+
+#ifdef _WIN32
+class CSHA1TreeWalker::CWalkDirHandle
+{
+};
+#else
+class CSHA1TreeWalker::CWalkDirHandle
+{
+public:
+	explicit CWalkDirHandle(int fd) : m_fd(fd) { }
+	~CWalkDirHandle() { close(m_fd); }
+
+	int Get() const { return m_fd; }
+
+private:
+	CWalkDirHandle(const CWalkDirHandle&);
+	CWalkDirHandle& operator=(const CWalkDirHandle&);
+
+	int m_fd;
+};
+#endif
+
+static bool SHA1WalkIsDots(const TCHAR* tszName)
+{
+	return ((tszName[0] == _T('.')) && ((tszName[1] == 0) || ((tszName[1] == _T('.')) &&
+		(tszName[2] == 0))));
+}
+
+CSHA1TreeWalker::CSHA1TreeWalker(size_t uThreads) :
+	m_uThreads(uThreads), m_bReportHardLinks(false), m_uBusy(0), m_uFiles(0),
+	m_uDirectories(0), m_uErrors(0)
+{
+	if(m_uThreads == 0) m_uThreads = std::thread::hardware_concurrency();
+	if(m_uThreads == 0) m_uThreads = 1;
+}
+
+bool CSHA1TreeWalker::Walk(const TCHAR* tszRoot, const SHA1_WALK_CALLBACK& fnFile)
+{
+	if(tszRoot == NULL) return false;
+
+	m_uFiles.store(0);
+	m_uDirectories.store(0);
+	m_uErrors.store(0);
+	m_setLinks.clear();
+	m_vStack.clear();
+	m_uBusy = 0;
+
+	// The root is read by the calling thread, which then joins the workers
+	WALK_DIR d;
+	d.strPath = tszRoot;
+	d.uNameOffset = 0;
+
+	std::vector<UINT_64> vBuffer;
+#ifndef _WIN32
+	vBuffer.resize(SHA1_WALK_BUFFER / sizeof(UINT_64));
+#endif
+	ReadDirectory(d, fnFile, vBuffer);
+	if(m_uDirectories.load() == 0) return false;
+
+	std::vector<std::thread> vThreads;
+	for(size_t i = 1; i < m_uThreads; ++i)
+		vThreads.push_back(std::thread(&CSHA1TreeWalker::WorkerMain, this, std::cref(fnFile)));
+	WorkerMain(fnFile);
+
+	for(size_t i = 0; i < vThreads.size(); ++i) vThreads[i].join();
+	return true;
+}
+
+void CSHA1TreeWalker::WorkerMain(const SHA1_WALK_CALLBACK& fnFile)
+{
+	std::vector<UINT_64> vBuffer;
+#ifndef _WIN32
+	vBuffer.resize(SHA1_WALK_BUFFER / sizeof(UINT_64));
+#endif
+
+	while(true)
+	{
+		WALK_DIR d;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			while(m_vStack.empty() && (m_uBusy != 0)) m_cv.wait(lock);
+			if(m_vStack.empty()) return; // Nothing queued and nobody left to queue more
+
+			d = std::move(m_vStack.back());
+			m_vStack.pop_back();
+			++m_uBusy;
+		}
+
+		ReadDirectory(d, fnFile, vBuffer);
+
+		std::lock_guard<std::mutex> lock(m_mtx);
+		if((--m_uBusy == 0) && m_vStack.empty()) m_cv.notify_all();
+	}
+}
+
+void CSHA1TreeWalker::PushDirectories(std::vector<WALK_DIR>& vDirs)
+{
+	if(vDirs.empty()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		for(size_t i = 0; i < vDirs.size(); ++i) m_vStack.push_back(std::move(vDirs[i]));
+	}
+
+	if(vDirs.size() == 1) m_cv.notify_one();
+	else m_cv.notify_all();
+	vDirs.clear();
+}
+
+bool CSHA1TreeWalker::IsFirstLink(const SHA1_FILE_ID& id)
+{
+	std::lock_guard<std::mutex> lock(m_mtxLinks);
+	return m_setLinks.insert(std::make_pair(id.uDevice, id.uInode)).second;
+}
+
+#ifdef _WIN32
+
+void CSHA1TreeWalker::ReadDirectory(WALK_DIR& d, const SHA1_WALK_CALLBACK& fnFile,
+	std::vector<UINT_64>& vBuffer)
+{
+	(void)vBuffer;
+
+	std::basic_string<TCHAR> strPrefix = d.strPath;
+	if(strPrefix.empty() || (strPrefix[strPrefix.size() - 1] != SHA1_WALK_SEPARATOR))
+		strPrefix += SHA1_WALK_SEPARATOR;
+
+	WIN32_FIND_DATA wfd;
+	HANDLE hFind = FindFirstFileEx((strPrefix + _T("*")).c_str(), FindExInfoBasic, &wfd,
+		FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+	if(hFind == INVALID_HANDLE_VALUE) { ++m_uErrors; return; }
+	++m_uDirectories;
+
+	std::vector<WALK_DIR> vDirs;
+	do
+	{
+		if(SHA1WalkIsDots(wfd.cFileName)) continue;
+		if((wfd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0) continue; // Not followed
+
+		if((wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+		{
+			WALK_DIR c;
+			c.strPath = strPrefix + wfd.cFileName;
+			c.uNameOffset = 0;
+			vDirs.push_back(c);
+			continue;
+		}
+
+		// The file index is not part of the directory listing; as the link
+		// count is neither, every file is checked for hard links
+		SHA1_WALK_ENTRY e;
+		e.strPath = strPrefix + wfd.cFileName;
+		if(!SHA1GetFileId(e.strPath.c_str(), e.id)) { ++m_uErrors; continue; }
+		if(!m_bReportHardLinks && !IsFirstLink(e.id)) continue;
+
+		++m_uFiles;
+		fnFile(e);
+	}
+	while(FindNextFile(hFind, &wfd) != FALSE);
+
+	if(GetLastError() != ERROR_NO_MORE_FILES) ++m_uErrors;
+	FindClose(hFind);
+
+	PushDirectories(vDirs);
+}
+
+#else // !_WIN32
+
+void CSHA1TreeWalker::ReadDirectory(WALK_DIR& d, const SHA1_WALK_CALLBACK& fnFile,
+	std::vector<UINT_64>& vBuffer)
+{
+	// Subdirectories are opened relative to their parent, which is closed
+	// once its last queued child has been opened. Symbolic links are only
+	// followed for the root; below it they are skipped.
+	const int fdParent = (d.pParent ? d.pParent->Get() : AT_FDCWD);
+	const int fd = openat(fdParent, d.strPath.c_str() + d.uNameOffset, O_RDONLY |
+		O_DIRECTORY | (d.pParent ? O_NOFOLLOW : 0) | O_CLOEXEC);
+	d.pParent.reset();
+	if(fd < 0) { ++m_uErrors; return; }
+	++m_uDirectories;
+
+	std::shared_ptr<CWalkDirHandle> pDir = std::make_shared<CWalkDirHandle>(fd);
+
+	std::basic_string<TCHAR> strPrefix = d.strPath;
+	if(strPrefix.empty() || (strPrefix[strPrefix.size() - 1] != SHA1_WALK_SEPARATOR))
+		strPrefix += SHA1_WALK_SEPARATOR;
+
+	std::vector<WALK_DIR> vDirs;
+	WALK_DIR c;
+	c.pParent = pDir;
+	c.uNameOffset = strPrefix.size();
+
+	SHA1_WALK_ENTRY e;
+
+#ifdef SHA1_WALK_LINUX
+	char* pbBuffer = reinterpret_cast<char*>(&vBuffer[0]);
+	const size_t uBufferSize = vBuffer.size() * sizeof(UINT_64);
+	while(true)
+	{
+		const long lRead = syscall(SYS_getdents64, fd, pbBuffer, uBufferSize);
+		if(lRead == 0) break;
+		if(lRead < 0) { ++m_uErrors; break; }
+
+		for(long lPos = 0; lPos < lRead; )
+		{
+			const SHA1_DIRENT64* pEntry = reinterpret_cast<const SHA1_DIRENT64*>(&pbBuffer[lPos]);
+			lPos += pEntry->d_reclen;
+
+			const char* pszName = pEntry->d_name;
+			if(SHA1WalkIsDots(pszName)) continue;
+
+			// Directories are known from the entry type, without statx
+			bool bDirectory = (pEntry->d_type == DT_DIR);
+			if(!bDirectory && (pEntry->d_type != DT_REG) && (pEntry->d_type != DT_UNKNOWN))
+				continue;
+
+			struct statx stx;
+			if(!bDirectory)
+			{
+				if(statx(fd, pszName, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT,
+					SHA1_WALK_STATX_MASK, &stx) != 0) { ++m_uErrors; continue; }
+				bDirectory = S_ISDIR(stx.stx_mode);
+				if(!bDirectory && !S_ISREG(stx.stx_mode)) continue;
+			}
+
+			if(bDirectory)
+			{
+				c.strPath = strPrefix + pszName;
+				vDirs.push_back(c);
+				continue;
+			}
+
+			e.id.uDevice = static_cast<UINT_64>(makedev(stx.stx_dev_major, stx.stx_dev_minor));
+			e.id.uInode = stx.stx_ino;
+			e.id.uSize = stx.stx_size;
+			e.id.iMTimeNs = (static_cast<INT_64>(stx.stx_mtime.tv_sec) * 1000000000LL) +
+				stx.stx_mtime.tv_nsec;
+			e.id.iCTimeNs = (static_cast<INT_64>(stx.stx_ctime.tv_sec) * 1000000000LL) +
+				stx.stx_ctime.tv_nsec;
+			if(!m_bReportHardLinks && (stx.stx_nlink > 1) && !IsFirstLink(e.id)) continue;
+
+			e.strPath = strPrefix + pszName;
+			++m_uFiles;
+			fnFile(e);
+		}
+	}
+#else
+	(void)vBuffer;
+
+	// readdir needs its own descriptor, as fd stays open for the children
+	const int fdList = dup(fd);
+	DIR* pList = ((fdList >= 0) ? fdopendir(fdList) : NULL);
+	if(pList == NULL)
+	{
+		if(fdList >= 0) close(fdList);
+		++m_uErrors;
+		return;
+	}
+
+	while(true)
+	{
+		errno = 0;
+		const struct dirent* pEntry = readdir(pList);
+		if(pEntry == NULL) { if(errno != 0) ++m_uErrors; break; }
+
+		const char* pszName = pEntry->d_name;
+		if(SHA1WalkIsDots(pszName)) continue;
+
+		struct stat st;
+		if(fstatat(fd, pszName, &st, AT_SYMLINK_NOFOLLOW) != 0) { ++m_uErrors; continue; }
+
+		if(S_ISDIR(st.st_mode))
+		{
+			c.strPath = strPrefix + pszName;
+			vDirs.push_back(c);
+			continue;
+		}
+		if(!S_ISREG(st.st_mode)) continue;
+
+		SHA1StatToFileId(st, e.id);
+		if(!m_bReportHardLinks && (st.st_nlink > 1) && !IsFirstLink(e.id)) continue;
+
+		e.strPath = strPrefix + pszName;
+		++m_uFiles;
+		fnFile(e);
+	}
+
+	closedir(pList);
+#endif
+
+	PushDirectories(vDirs);
+}
+
+#endif // _WIN32
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+namespace
+{
+	// Requests of one HashTree call that have not completed yet; shared by
+	// the requests, as they may complete after HashTree has returned
+	struct SHA1_WALK_PENDING
+	{
+		std::mutex mtx;
+		std::condition_variable cv;
+		size_t uCount;
+	};
+
+	// Owns the walk entry (and thus the path) until the file is hashed
+	class CSHA1WalkHashRequest : public CSHA1AsyncRequest
+	{
+	public:
+		CSHA1WalkHashRequest(const SHA1_WALK_ENTRY& e, const SHA1_WALK_HASH_CALLBACK& fnResult,
+			const std::shared_ptr<SHA1_WALK_PENDING>& pPending) :
+			m_entry(e), m_fnResult(fnResult), m_pPending(pPending)
+		{
+			SetFile(m_entry.strPath.c_str());
+		}
+
+	protected:
+		void OnComplete()
+		{
+			if(m_fnResult) m_fnResult(m_entry, GetResult());
+
+			{
+				std::lock_guard<std::mutex> lock(m_pPending->mtx);
+				--m_pPending->uCount;
+			}
+			m_pPending->cv.notify_one();
+
+			delete this;
+		}
+
+	private:
+		SHA1_WALK_ENTRY m_entry;
+		SHA1_WALK_HASH_CALLBACK m_fnResult;
+		std::shared_ptr<SHA1_WALK_PENDING> m_pPending;
+	};
+}
+
+bool CSHA1TreeWalker::HashTree(const TCHAR* tszRoot, CSHA1AsyncHasher& hasher,
+	const SHA1_WALK_HASH_CALLBACK& fnResult)
+{
+	std::shared_ptr<SHA1_WALK_PENDING> pPending(new SHA1_WALK_PENDING());
+	pPending->uCount = 0;
+
+	return Walk(tszRoot, [&hasher, &fnResult, &pPending](const SHA1_WALK_ENTRY& e)
+	{
+		{
+			// Hold back the walker threads while the hasher is behind
+			std::unique_lock<std::mutex> lock(pPending->mtx);
+			pPending->cv.wait(lock, [&pPending]() {
+				return (pPending->uCount < SHA1_WALK_MAX_PENDING); });
+			++pPending->uCount;
+		}
+
+		hasher.Submit(new CSHA1WalkHashRequest(e, fnResult, pPending));
+	});
+}
+#endif
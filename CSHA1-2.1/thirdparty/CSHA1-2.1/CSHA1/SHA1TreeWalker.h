@@ -0,0 +1,137 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  Parallel directory tree walker. See SHA1.h for version history.
+
+  Directories are read by a set of threads; every regular file is
+  reported as soon as it is found, so hashing overlaps with the walk.
+  On Linux, directories are read with getdents64 into a large buffer,
+  opened with openat relative to their parent and the files are
+  examined with statx relative to the directory, requesting only the
+  fields of SHA1_FILE_ID. Directory entries that are known to be
+  subdirectories are not examined at all.
+
+  Symbolic links below the root are not followed (the root itself may be
+  one). Hard links are recognized by device and inode, so each file is
+  reported once (unless disabled).
+
+    CSHA1AsyncHasher& hasher = CSHA1AsyncHasher::GetDefault();
+    CSHA1TreeWalker w;
+    w.HashTree(tszRoot, hasher, OnFileHashed);
+    hasher.Wait();
+*/
+
+#ifndef SHA1TREEWALKER_H_8C2E5A7F1D3B4C69A0E4F6B8D1C3A5E7
+#define SHA1TREEWALKER_H_8C2E5A7F1D3B4C69A0E4F6B8D1C3A5E7
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "SHA1.h"
+#include "SHA1Async.h"
+#include "SHA1FileInfo.h"
+
+// Size of the directory entry buffer of each walker thread
+#ifndef SHA1_WALK_BUFFER
+#define SHA1_WALK_BUFFER (256 * 1024)
+#endif
+
+// Files submitted by HashTree that may be waiting for the hasher at once
+#ifndef SHA1_WALK_MAX_PENDING
+#define SHA1_WALK_MAX_PENDING 4096
+#endif
+
+typedef struct
+{
+	std::basic_string<TCHAR> strPath;
+	SHA1_FILE_ID id;
+} SHA1_WALK_ENTRY;
+
+// Invoked concurrently by the walker threads
+typedef std::function<void(const SHA1_WALK_ENTRY&)> SHA1_WALK_CALLBACK;
+
+// Invoked like any other completion of the CSHA1AsyncHasher
+typedef std::function<void(const SHA1_WALK_ENTRY&, const SHA1_ASYNC_RESULT&)>
+	SHA1_WALK_HASH_CALLBACK;
+
+class CSHA1TreeWalker
+{
+public:
+	// If uThreads is 0, one thread per hardware thread is used
+	explicit CSHA1TreeWalker(size_t uThreads = 0);
+
+	// Report every hard link of a file instead of the file once
+	void SetReportHardLinks(bool bReport) { m_bReportHardLinks = bReport; }
+
+	// Calls fnFile for each regular file below tszRoot; returns when the
+	// walk is complete. False if tszRoot cannot be read; errors below it
+	// are counted (GetErrorCount) and the walk continues.
+	bool Walk(const TCHAR* tszRoot, const SHA1_WALK_CALLBACK& fnFile);
+
+#ifdef SHA1_UTILITY_FUNCTIONS
+	// Submits each file to the hasher as soon as it is found; returns when
+	// the walk is complete, hashing may still be in progress then. The
+	// walker threads wait while SHA1_WALK_MAX_PENDING files are pending,
+	// so with deferred completions HashTree must not be called on the
+	// thread that dispatches them.
+	bool HashTree(const TCHAR* tszRoot, CSHA1AsyncHasher& hasher,
+		const SHA1_WALK_HASH_CALLBACK& fnResult);
+#endif
+
+	// Statistics of the last walk
+	UINT_64 GetFileCount() const { return m_uFiles.load(); }
+	UINT_64 GetDirectoryCount() const { return m_uDirectories.load(); }
+	UINT_64 GetErrorCount() const { return m_uErrors.load(); }
+
+private:
+	class CWalkDirHandle;
+
+	struct WALK_DIR
+	{
+		std::shared_ptr<CWalkDirHandle> pParent; // Open while children are queued
+		std::basic_string<TCHAR> strPath;
+		size_t uNameOffset; // Name within the parent directory
+	};
+
+	struct LINK_KEY_HASH
+	{
+		size_t operator()(const std::pair<UINT_64, UINT_64>& k) const
+		{
+			return static_cast<size_t>((k.second * 0x9E3779B97F4A7C15ULL) ^ k.first);
+		}
+	};
+
+	void WorkerMain(const SHA1_WALK_CALLBACK& fnFile);
+	void ReadDirectory(WALK_DIR& d, const SHA1_WALK_CALLBACK& fnFile,
+		std::vector<UINT_64>& vBuffer);
+	void PushDirectories(std::vector<WALK_DIR>& vDirs);
+	bool IsFirstLink(const SHA1_FILE_ID& id);
+
+	CSHA1TreeWalker(const CSHA1TreeWalker&);
+	CSHA1TreeWalker& operator=(const CSHA1TreeWalker&);
+
+	size_t m_uThreads;
+	bool m_bReportHardLinks;
+
+	std::vector<WALK_DIR> m_vStack; // Depth first, bounds the open handles
+	size_t m_uBusy;
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+
+	std::unordered_set<std::pair<UINT_64, UINT_64>, LINK_KEY_HASH> m_setLinks;
+	std::mutex m_mtxLinks;
+
+	std::atomic<UINT_64> m_uFiles;
+	std::atomic<UINT_64> m_uDirectories;
+	std::atomic<UINT_64> m_uErrors;
+};
+
+#endif // SHA1TREEWALKER_H_8C2E5A7F1D3B4C69A0E4F6B8D1C3A5E7
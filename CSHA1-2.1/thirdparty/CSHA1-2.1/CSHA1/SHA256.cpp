@@ -0,0 +1,283 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  See header file for version history and test vectors.
+*/
+
+#include "SHA256.h"
+#include "SHA1Probes.h"
+#include "SHA1Stats.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SHA256_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SHA256_TARGET_NI
+#else
+#include <cpuid.h>
+#define SHA256_TARGET_NI __attribute__((target("sha,sse4.1,ssse3")))
+#endif
+#endif
+
+#define ROR32(v,n) (((v) >> (n)) | ((v) << (32 - (n))))
+
+static const UINT_32 g_pSha256K[64] = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static void SHA256TransformPortable(UINT_32* pState, const UINT_8* pbBlocks, size_t uBlocks)
+{
+	UINT_32 w[64];
+
+	for( ; uBlocks != 0; --uBlocks, pbBlocks += 64)
+	{
+		for(size_t i = 0; i < 16; ++i)
+			w[i] = (static_cast<UINT_32>(pbBlocks[i * 4]) << 24) |
+				(static_cast<UINT_32>(pbBlocks[(i * 4) + 1]) << 16) |
+				(static_cast<UINT_32>(pbBlocks[(i * 4) + 2]) << 8) |
+				static_cast<UINT_32>(pbBlocks[(i * 4) + 3]);
+
+		for(size_t i = 16; i < 64; ++i)
+		{
+			const UINT_32 s0 = ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+			const UINT_32 s1 = ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		UINT_32 a = pState[0], b = pState[1], c = pState[2], d = pState[3];
+		UINT_32 e = pState[4], f = pState[5], g = pState[6], h = pState[7];
+
+		for(size_t i = 0; i < 64; ++i)
+		{
+			const UINT_32 t1 = h + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) +
+				((e & f) ^ (~e & g)) + g_pSha256K[i] + w[i];
+			const UINT_32 t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) +
+				((a & b) ^ (a & c) ^ (b & c));
+			h = g; g = f; f = e; e = d + t1;
+			d = c; c = b; b = a; a = t1 + t2;
+		}
+
+		pState[0] += a; pState[1] += b; pState[2] += c; pState[3] += d;
+		pState[4] += e; pState[5] += f; pState[6] += g; pState[7] += h;
+	}
+}
+
+#ifdef SHA256_X86
+static bool SHA256HasShaNi()
+{
+	unsigned int uEbx7 = 0, uEcx1 = 0;
+#ifdef _MSC_VER
+	int pInfo[4];
+	__cpuid(pInfo, 0);
+	if(pInfo[0] < 7) return false;
+	__cpuid(pInfo, 1);
+	uEcx1 = static_cast<unsigned int>(pInfo[2]);
+	__cpuidex(pInfo, 7, 0);
+	uEbx7 = static_cast<unsigned int>(pInfo[1]);
+#else
+	unsigned int a, b, c, d;
+	if(__get_cpuid_max(0, NULL) < 7) return false;
+	__cpuid(1, a, b, c, d);
+	uEcx1 = c;
+	__cpuid_count(7, 0, a, b, c, d);
+	uEbx7 = b;
+#endif
+
+	// SSSE3, SSE4.1 and SHA
+	return (((uEcx1 & (1U << 9)) != 0) && ((uEcx1 & (1U << 19)) != 0) &&
+		((uEbx7 & (1U << 29)) != 0));
+}
+
+// Four rounds of group g; m is the message quadruple of the group, mPrev
+// the one before, mNext the one after (which is completed here)
+#define SHA256_NI_QROUND(g, m, mPrev, mNext, bMsg2, bMsg1) { \
+	msg = _mm_add_epi32(m, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&g_pSha256K[(g) * 4]))); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+	if(bMsg2) { tmp = _mm_alignr_epi8(m, mPrev, 4); mNext = _mm_add_epi32(mNext, tmp); \
+		mNext = _mm_sha256msg2_epu32(mNext, m); } \
+	msg = _mm_shuffle_epi32(msg, 0x0E); \
+	state0 = _mm_sha256rnds2_epu32(state0, state1, msg); \
+	if(bMsg1) mPrev = _mm_sha256msg1_epu32(mPrev, m); }
+
+SHA256_TARGET_NI static void SHA256TransformNi(UINT_32* pState, const UINT_8* pbBlocks,
+	size_t uBlocks)
+{
+	const __m128i vMask = _mm_set_epi64x(0x0C0D0E0F08090A0BLL, 0x0405060700010203LL);
+
+	__m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pState[0]));
+	__m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pState[4]));
+	tmp = _mm_shuffle_epi32(tmp, 0xB1); // CDAB
+	state1 = _mm_shuffle_epi32(state1, 0x1B); // EFGH
+	__m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0); // CDGH
+
+	for( ; uBlocks != 0; --uBlocks, pbBlocks += 64)
+	{
+		const __m128i abefSave = state0;
+		const __m128i cdghSave = state1;
+		__m128i msg;
+
+		__m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pbBlocks)), vMask);
+		__m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pbBlocks + 16)), vMask);
+		__m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pbBlocks + 32)), vMask);
+		__m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pbBlocks + 48)), vMask);
+
+		SHA256_NI_QROUND(0, m0, m3, m1, false, false);
+		SHA256_NI_QROUND(1, m1, m0, m2, false, true);
+		SHA256_NI_QROUND(2, m2, m1, m3, false, true);
+		SHA256_NI_QROUND(3, m3, m2, m0, true, true);
+		SHA256_NI_QROUND(4, m0, m3, m1, true, true);
+		SHA256_NI_QROUND(5, m1, m0, m2, true, true);
+		SHA256_NI_QROUND(6, m2, m1, m3, true, true);
+		SHA256_NI_QROUND(7, m3, m2, m0, true, true);
+		SHA256_NI_QROUND(8, m0, m3, m1, true, true);
+		SHA256_NI_QROUND(9, m1, m0, m2, true, true);
+		SHA256_NI_QROUND(10, m2, m1, m3, true, true);
+		SHA256_NI_QROUND(11, m3, m2, m0, true, true);
+		SHA256_NI_QROUND(12, m0, m3, m1, true, true);
+		SHA256_NI_QROUND(13, m1, m0, m2, true, false);
+		SHA256_NI_QROUND(14, m2, m1, m3, true, false);
+		SHA256_NI_QROUND(15, m3, m2, m0, false, false);
+
+		state0 = _mm_add_epi32(state0, abefSave);
+		state1 = _mm_add_epi32(state1, cdghSave);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+	state1 = _mm_shuffle_epi32(state1, 0xB1); // DCHG
+	state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+	state1 = _mm_alignr_epi8(state1, tmp, 8); // ABEF
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(&pState[0]), state0);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(&pState[4]), state1);
+}
+
+static bool SHA256UseNi()
+{
+	static const bool bNi = SHA256HasShaNi();
+	return bNi;
+}
+#endif
+
+bool CSHA256::IsAccelerated()
+{
+#ifdef SHA256_X86
+	return SHA256UseNi();
+#else
+	return false;
+#endif
+}
+
+CSHA256::CSHA256()
+{
+	Reset();
+}
+
+#ifdef SHA1_WIPE_VARIABLES
+CSHA256::~CSHA256()
+{
+	Reset();
+}
+#endif
+
+void CSHA256::Reset()
+{
+	m_state[0] = 0x6A09E667;
+	m_state[1] = 0xBB67AE85;
+	m_state[2] = 0x3C6EF372;
+	m_state[3] = 0xA54FF53A;
+	m_state[4] = 0x510E527F;
+	m_state[5] = 0x9B05688C;
+	m_state[6] = 0x1F83D9AB;
+	m_state[7] = 0x5BE0CD19;
+
+	m_uCount = 0;
+
+#ifdef SHA1_WIPE_VARIABLES
+	memset(m_buffer, 0, 64);
+	memset(m_digest, 0, 32);
+#endif
+}
+
+void CSHA256::Transform(const UINT_8* pbBlocks, size_t uBlocks)
+{
+#ifdef SHA256_X86
+	if(SHA256UseNi()) { SHA256TransformNi(m_state, pbBlocks, uBlocks); return; }
+#endif
+	SHA256TransformPortable(m_state, pbBlocks, uBlocks);
+}
+
+void CSHA256::Update(const UINT_8* pbData, UINT_32 uLen)
+{
+	if((pbData == NULL) || (uLen == 0)) return;
+
+	size_t j = static_cast<size_t>(m_uCount & 0x3F);
+	m_uCount += uLen;
+
+	size_t i = 0;
+	if(j != 0)
+	{
+		i = (((64 - j) < uLen) ? (64 - j) : uLen);
+		memcpy(&m_buffer[j], pbData, i);
+		j += i;
+		if(j < 64) return;
+
+		Transform(m_buffer, 1);
+	}
+
+	const size_t uBlocks = (uLen - i) >> 6;
+	if(uBlocks != 0)
+	{
+		Transform(&pbData[i], uBlocks);
+		i += (uBlocks << 6);
+	}
+
+	if(i < uLen) memcpy(m_buffer, &pbData[i], uLen - i);
+}
+
+void CSHA256::Final()
+{
+	if(SHA1StatsEnabled() || SHA1_PROBE_ENABLED(final))
+	{
+		const int iKernel = (IsAccelerated() ? SHA1_STATS_KERNEL_SHA256_NI :
+			SHA1_STATS_KERNEL_SHA256);
+		if(SHA1StatsEnabled()) SHA1StatsAddMessage(iKernel, m_uCount);
+		SHA1_PROBE2(final, m_uCount, iKernel);
+	}
+
+	const UINT_64 uBits = (m_uCount << 3);
+
+	UINT_8 pbPad[72];
+	memset(pbPad, 0, sizeof(pbPad));
+	pbPad[0] = 0x80;
+
+	const size_t j = static_cast<size_t>(m_uCount & 0x3F);
+	const size_t uPad = ((j < 56) ? (56 - j) : (120 - j));
+	for(size_t i = 0; i < 8; ++i)
+		pbPad[uPad + i] = static_cast<UINT_8>((uBits >> (56 - (i * 8))) & 0xFF);
+	Update(pbPad, static_cast<UINT_32>(uPad + 8));
+
+	for(size_t i = 0; i < 32; ++i)
+		m_digest[i] = static_cast<UINT_8>((m_state[i >> 2] >> ((3 - (i & 3)) * 8)) & 0xFF);
+
+#ifdef SHA1_WIPE_VARIABLES
+	memset(m_buffer, 0, 64);
+#endif
+}
+
+bool CSHA256::GetHash(UINT_8* pbDest32) const
+{
+	if(pbDest32 == NULL) return false;
+	memcpy(pbDest32, m_digest, 32);
+	return true;
+}
@@ -0,0 +1,54 @@
+/*
+  100% free public domain implementation of the SHA-1 algorithm
+  by Dominik Reichl <dominik.reichl@t-online.de>
+  Web: http://www.dominik-reichl.de/
+
+  SHA-256 with the same interface as CSHA1, used by the multi-digest
+  hasher (SHA1MultiHash.h). See SHA1.h for version history.
+
+  The x86 SHA extensions (SHA-NI) are used if the processor supports
+  them, otherwise a portable implementation.
+
+  ================ Test Vectors ================
+
+  SHA256("abc" in ANSI) =
+    BA7816BF 8F01CFEA 414140DE 5DAE2223 B00361A3 96177A9C B410FF61 F20015AD
+*/
+
+#ifndef SHA256_H_2E9F4C7A1D3B4E8F9A0C6B2D5E7F1A34
+#define SHA256_H_2E9F4C7A1D3B4E8F9A0C6B2D5E7F1A34
+
+#include "SHA1.h"
+
+class CSHA256
+{
+public:
+	CSHA256();
+
+#ifdef SHA1_WIPE_VARIABLES
+	~CSHA256();
+#endif
+
+	void Reset();
+
+	void Update(const UINT_8* pbData, UINT_32 uLen);
+
+	// Finalize hash; call it before using GetHash
+	void Final();
+
+	// Get the raw message digest (32 bytes)
+	bool GetHash(UINT_8* pbDest32) const;
+
+	// Whether the SHA-NI implementation is used
+	static bool IsAccelerated();
+
+private:
+	void Transform(const UINT_8* pbBlocks, size_t uBlocks);
+
+	UINT_32 m_state[8];
+	UINT_64 m_uCount; // Bytes
+	UINT_8 m_buffer[64];
+	UINT_8 m_digest[32];
+};
+
+#endif // SHA256_H_2E9F4C7A1D3B4E8F9A0C6B2D5E7F1A34